@@ -118,6 +118,31 @@ public:
         }
     }
 
+    // surface area of the box (zero for an empty box)
+    double surface_area() const
+    {
+        if (x.size() < 0 || y.size() < 0 || z.size() < 0)
+        {
+            return 0;
+        }
+
+        return 2 * (x.size() * y.size() + y.size() * z.size() + z.size() * x.size());
+    }
+
+    // center point of the box
+    point3 centroid() const
+    {
+        return point3(0.5 * (x.min + x.max), 0.5 * (y.min + y.max), 0.5 * (z.min + z.max));
+    }
+
+    // grow the box to enclose the point
+    void enclose(const point3 &p)
+    {
+        x = interval(std::fmin(x.min, p.x()), std::fmax(x.max, p.x()));
+        y = interval(std::fmin(y.min, p.y()), std::fmax(y.max, p.y()));
+        z = interval(std::fmin(z.min, p.z()), std::fmax(z.max, p.z()));
+    }
+
     static const AA_bounding_box empty, universe;
 
 private:
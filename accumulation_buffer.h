@@ -0,0 +1,153 @@
+#ifndef ACCUMULATION_BUFFER_H
+#define ACCUMULATION_BUFFER_H
+
+// header file for the linear radiance the camera collects, a running sum, squared luminance sum, and sample count per
+// pixel, so more samples can be added later, partial renders of the same image can be merged, and noise can be measured
+
+// include
+#include "utility.h"
+#include "image_writer.h"
+
+// accumulation_buffer
+struct accumulation_buffer
+{
+    int width = 0, height = 0;
+
+    // summed rgb radiance, three floats per pixel in scanline order
+    std::vector<float> sum;
+
+    // samples taken in every pixel
+    std::vector<uint32_t> samples;
+
+    // summed squared luminance of the samples of every pixel, for the noise estimate
+    std::vector<float> luminance_squares;
+
+    // constructors
+    accumulation_buffer() {}
+    accumulation_buffer(int width, int height) { reset(width, height); }
+
+    // clear to an empty image of the given size
+    void reset(int new_width, int new_height)
+    {
+        width = new_width;
+        height = new_height;
+        sum.assign(size_t(width) * height * 3, 0.0f);
+        samples.assign(size_t(width) * height, 0);
+        luminance_squares.assign(size_t(width) * height, 0.0f);
+    }
+
+    // add the sum of count samples, and the sum of their squared luminance, to one pixel
+    void add(int i, int j, const color &sample_sum, uint32_t count, double luminance_square_sum = 0)
+    {
+        size_t pixel = size_t(j) * width + i;
+        float *rgb = &sum[pixel * 3];
+
+        rgb[0] += static_cast<float>(sample_sum.x());
+        rgb[1] += static_cast<float>(sample_sum.y());
+        rgb[2] += static_cast<float>(sample_sum.z());
+        samples[pixel] += count;
+        luminance_squares[pixel] += static_cast<float>(luminance_square_sum);
+    }
+
+    // luminance of a color
+    static double luminance(const color &c)
+    {
+        return 0.2126 * c.x() + 0.7152 * c.y() + 0.0722 * c.z();
+    }
+
+    // standard error of the mean luminance of one pixel relative to that mean (infinite below two samples)
+    double relative_error(size_t pixel) const
+    {
+        uint32_t n = samples[pixel];
+
+        if (n < 2)
+        {
+            return infinity;
+        }
+
+        double mean = (0.2126 * sum[pixel * 3] + 0.7152 * sum[pixel * 3 + 1] + 0.0722 * sum[pixel * 3 + 2]) / n;
+        double variance = std::max(0.0, (luminance_squares[pixel] - n * mean * mean) / (n - 1));
+
+        // dark pixels are judged against a small floor so black areas do not count as endlessly noisy
+        return std::sqrt(variance / n) / std::max(mean, 0.01);
+    }
+
+    // mean relative error over the image
+    double mean_relative_error() const
+    {
+        double total = 0;
+
+        for (size_t pixel = 0; pixel < samples.size(); pixel++)
+        {
+            total += relative_error(pixel);
+        }
+
+        return samples.empty() ? 0 : total / samples.size();
+    }
+
+    // fewest samples any pixel has
+    uint32_t min_samples() const
+    {
+        return samples.empty() ? 0 : *std::min_element(samples.begin(), samples.end());
+    }
+
+    // samples taken in all the pixels together
+    uint64_t total_samples() const
+    {
+        uint64_t total = 0;
+
+        for (uint32_t count : samples)
+        {
+            total += count;
+        }
+
+        return total;
+    }
+
+    // samples taken in one pixel
+    uint32_t sample_count(int i, int j) const
+    {
+        return samples[size_t(j) * width + i];
+    }
+
+    // add the samples of another render of the same image, false if the sizes differ
+    bool merge(const accumulation_buffer &other)
+    {
+        if (other.width != width || other.height != height)
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < sum.size(); i++)
+        {
+            sum[i] += other.sum[i];
+        }
+
+        for (size_t i = 0; i < samples.size(); i++)
+        {
+            samples[i] += other.samples[i];
+            luminance_squares[i] += other.luminance_squares[i];
+        }
+
+        return true;
+    }
+
+    // mean radiance of every pixel (pixels without samples are black)
+    framebuffer resolve() const
+    {
+        framebuffer image(width, height);
+
+        for (size_t pixel = 0; pixel < samples.size(); pixel++)
+        {
+            float scale = samples[pixel] > 0 ? 1.0f / samples[pixel] : 0.0f;
+
+            image.rgb[pixel * 3] = sum[pixel * 3] * scale;
+            image.rgb[pixel * 3 + 1] = sum[pixel * 3 + 1] * scale;
+            image.rgb[pixel * 3 + 2] = sum[pixel * 3 + 2] * scale;
+        }
+
+        return image;
+    }
+};
+
+#endif
@@ -25,8 +25,8 @@ void configurable_camera()
     texture_vector tv = texture_vector(40, 20, 10);
 
     // spheres
-    scene.add_sphere(point3(-1, 0.5, 0), 1, "diffuse", tv);
-    scene.add_sphere(point3(1, 0.5, 0), 1, "diffuse", tv);
+    scene.add_sphere(point3(-1, 0.5, 0), 1, material_type::diffuse, tv);
+    scene.add_sphere(point3(1, 0.5, 0), 1, material_type::diffuse, tv);
 
     // camera settings
     camera cam;
@@ -55,7 +55,7 @@ void anti_aliasing()
     cam.configure(20, point3(0, 2, 6), point3(0, 1, 0), vec3(0, 1, 0));
 
     // sphere
-    scene.add_sphere(point3(0, 1, 0), 1, "diffuse", texture_vector(40, 20, 10));
+    scene.add_sphere(point3(0, 1, 0), 1, material_type::diffuse, texture_vector(40, 20, 10));
 
     // without anti-aliasing
     cam.render(scene, "anti-aliasing-without.ppm", false);
@@ -78,9 +78,9 @@ void sphere_intersections()
     texture_vector tv = texture_vector(40, 20, 10);
 
     // spheres
-    scene.add_sphere(point3(6, 2.5, 0), 3, "diffuse", tv);
-    scene.add_sphere(point3(0, 1.5, 0), 2, "diffuse", tv);
-    scene.add_sphere(point3(-5, 0.5, 0), 1, "diffuse", tv);
+    scene.add_sphere(point3(6, 2.5, 0), 3, material_type::diffuse, tv);
+    scene.add_sphere(point3(0, 1.5, 0), 2, material_type::diffuse, tv);
+    scene.add_sphere(point3(-5, 0.5, 0), 1, material_type::diffuse, tv);
 
     // render
     cam.render(scene, "spheres.ppm");
@@ -97,16 +97,16 @@ void triangle_intersections()
     cam.configure(80, point3(0, 0, 9), point3(0, 0, 0), vec3(0, 1, 0));
 
     // bottom left red triangle
-    scene.add_triangle(point3(-2, 3, 0), vec3(-7, 4, 0), vec3(-7, -1, 0), "diffuse", texture_vector(100, 20, 20));
+    scene.add_triangle(point3(-2, 3, 0), vec3(-7, 4, 0), vec3(-7, -1, 0), material_type::diffuse, texture_vector(100, 20, 20));
 
     // bottom right triangle
-    scene.add_triangle(point3(5, 2, 0), vec3(7, -2, 0), vec3(7, -4, 0), "diffuse", texture_vector(20, 20, 100));
+    scene.add_triangle(point3(5, 2, 0), vec3(7, -2, 0), vec3(7, -4, 0), material_type::diffuse, texture_vector(20, 20, 100));
 
     // top green
-    scene.add_triangle(point3(0, 0, 0), vec3(4, 0, 0), vec3(0, 4, 0), "diffuse", texture_vector(20, 100, 20));
+    scene.add_triangle(point3(0, 0, 0), vec3(4, 0, 0), vec3(0, 4, 0), material_type::diffuse, texture_vector(20, 100, 20));
 
     // center yellow
-    scene.add_triangle(point3(0, -6, 0), vec3(-4, 4, 0), vec3(4, 4, 0), "diffuse", texture_vector(100, 50, 0));
+    scene.add_triangle(point3(0, -6, 0), vec3(-4, 4, 0), vec3(4, 4, 0), material_type::diffuse, texture_vector(100, 50, 0));
 
     // render
     cam.render(scene, "triangles.ppm");
@@ -125,10 +125,10 @@ void load_textures()
     texture_vector tv = texture_vector(0, 0, 204);
 
     // spheres
-    scene.add_sphere(point3(6, 2.5, 0), 3, "diffuse", texture_vector(1));
-    scene.add_sphere(point3(0, 1.5, 0), 2, "diffuse", texture_vector(2));
-    scene.add_sphere(point3(-5, 0.5, 0), 1, "diffuse", texture_vector(204, 204, 204, 0, 0, 3));
-    scene.add_sphere(point3(-9, 0.5, 0), 1, "diffuse", texture_vector(0, 0, 204, 0, 0, 4));
+    scene.add_sphere(point3(6, 2.5, 0), 3, material_type::diffuse, texture_vector(1));
+    scene.add_sphere(point3(0, 1.5, 0), 2, material_type::diffuse, texture_vector(2));
+    scene.add_sphere(point3(-5, 0.5, 0), 1, material_type::diffuse, texture_vector(204, 204, 204, 0, 0, 3));
+    scene.add_sphere(point3(-9, 0.5, 0), 1, material_type::diffuse, texture_vector(0, 0, 204, 0, 0, 4));
 
     // render
     cam.render(scene, "loaded-texture.ppm");
@@ -145,7 +145,7 @@ void triangle_meshes()
     cam.configure(90, point3(0, 1, 2), point3(0, 8, -20), vec3(0, 1, 0));
 
     // stand
-    scene.add_sphere(point3(0, -4, -40), 6, "diffuse", texture_vector(102, 51, 0));
+    scene.add_sphere(point3(0, -4, -40), 6, material_type::diffuse, texture_vector(102, 51, 0));
 
     // load objects
     object loaded_mesh = object("Objects/castle.obj");
@@ -166,13 +166,13 @@ void materials()
     cam.configure(70, point3(0, 0, 1), point3(0, 0, -1.2), vec3(0, 1, 0));
 
     // specular
-    scene.add_sphere(point3(0, 0, -1.2), 0.5, "specular", texture_vector(80, 80, 0));
+    scene.add_sphere(point3(0, 0, -1.2), 0.5, material_type::specular, texture_vector(80, 80, 0));
 
     // diffuse
-    scene.add_sphere(point3(1, 0, -1), 0.5, "diffuse", texture_vector(40, 20, 10));
+    scene.add_sphere(point3(1, 0, -1), 0.5, material_type::diffuse, texture_vector(40, 20, 10));
 
     // dielectric
-    scene.add_sphere(point3(-1, 0, -1), 0.5, "dielectric", texture_vector(0, 0, 0, 0, 1.5));
+    scene.add_sphere(point3(-1, 0, -1), 0.5, material_type::dielectric, texture_vector(0, 0, 0, 0, 1.5));
 
     // render
     cam.render(scene, "materials.ppm");
@@ -189,10 +189,10 @@ void lights()
     cam.configure(20, point3(26, 3, 6), point3(0, 2, 0), vec3(0, 1, 0));
 
     // sphere
-    scene.add_sphere(point3(0, 1.5, 0), 2, "diffuse", texture_vector(10, 20, 50));
+    scene.add_sphere(point3(0, 1.5, 0), 2, material_type::diffuse, texture_vector(10, 20, 50));
 
     // light
-    scene.add_triangle(point3(3, 1, -2), vec3(2, 0, 0), vec3(0, 2, 0), "emissive", texture_vector(255, 255, 555));
+    scene.add_triangle(point3(3, 1, -2), vec3(2, 0, 0), vec3(0, 2, 0), material_type::emissive, texture_vector(255, 255, 555));
 
     // render
     cam.render(scene, "lights.ppm");
@@ -217,8 +217,8 @@ void quads()
     scene.add(make_shared<triangle>(point3(-10, 0, 0), vec3(0, 5, 0), vec3(5, 0, 0), make_shared<diffuse>(cool_texture)));
     scene.add(make_shared<quad>(point3(-2, -2, 0), vec3(4, 0, 0), vec3(0, 4, 0), make_shared<diffuse>(isu_texture)));
 
-    scene.add_quad(point3(3, -2, 1), vec3(0, 0, 4), vec3(0, 4, 0), "diffuse", tv);
-    scene.add_quad(point3(-2, 3, 1), vec3(4, 0, 0), vec3(0, 0, 4), "diffuse", tv);
+    scene.add_quad(point3(3, -2, 1), vec3(0, 0, 4), vec3(0, 4, 0), material_type::diffuse, tv);
+    scene.add_quad(point3(-2, 3, 1), vec3(4, 0, 0), vec3(0, 0, 4), material_type::diffuse, tv);
 
     // render
     cam.render(scene, "quads.ppm");
@@ -238,7 +238,7 @@ void motion_blur()
     texture_vector tv = texture_vector(100, 20, 20);
 
     // add sphere
-    scene.add_moving_sphere(point3(2, 1.5, 0), point3(0, 2, 0), 2, "diffuse", tv);
+    scene.add_moving_sphere(point3(2, 1.5, 0), point3(0, 2, 0), 2, material_type::diffuse, tv);
 
     // render
     cam.render(scene, "motion-blur.ppm");
@@ -258,8 +258,8 @@ void perlin_noise_example()
     texture_vector tv = texture_vector(50, 50, 50, 0, 0, 4);
 
     // add sphere and ground
-    scene.add_sphere(point3(0, -1000, 0), 1000, "diffuse", tv);
-    scene.add_sphere(point3(0, 2, 0), 2, "diffuse", tv);
+    scene.add_sphere(point3(0, -1000, 0), 1000, material_type::diffuse, tv);
+    scene.add_sphere(point3(0, 2, 0), 2, material_type::diffuse, tv);
 
     // render
     cam.render(scene, "perlin-noise.ppm");
@@ -279,7 +279,7 @@ void volume_rendering()
     auto white = make_shared<diffuse>(color(0, 0, 2.04));
     shared_ptr<hittable> smoke_sphere = make_shared<sphere>(point3(0, 1.5, 0), 2, white);
 
-    scene.add_volume(smoke_sphere, .01, "volume", texture_vector(0, 0, 0));
+    scene.add_volume(smoke_sphere, .01, material_type::volume, texture_vector(0, 0, 0));
 
     // render
     cam.render(scene, "volume.ppm");
@@ -300,20 +300,20 @@ void final_render()
     texture_vector path_tv = texture_vector(102, 51, 0);
 
     // main path
-    scene.add_quad(point3(-2, 0, 2), vec3(4, 0, 0), vec3(0, 0, -50), "diffuse", path_tv);
+    scene.add_quad(point3(-2, 0, 2), vec3(4, 0, 0), vec3(0, 0, -50), material_type::diffuse, path_tv);
 
     // left path segments
-    scene.add_quad(point3(-2, 0, -7), vec3(0, 0, -2), vec3(-10, 0, 0), "diffuse", path_tv);
-    scene.add_quad(point3(-2, 0, -16), vec3(0, 0, -2), vec3(-10, 0, 0), "diffuse", path_tv);
+    scene.add_quad(point3(-2, 0, -7), vec3(0, 0, -2), vec3(-10, 0, 0), material_type::diffuse, path_tv);
+    scene.add_quad(point3(-2, 0, -16), vec3(0, 0, -2), vec3(-10, 0, 0), material_type::diffuse, path_tv);
 
     // right path segments
-    scene.add_quad(point3(2, 0, -7), vec3(0, 0, -2), vec3(10, 0, 0), "diffuse", path_tv);
-    scene.add_quad(point3(2, 0, -16), vec3(0, 0, -2), vec3(10, 0, 0), "diffuse", path_tv);
+    scene.add_quad(point3(2, 0, -7), vec3(0, 0, -2), vec3(10, 0, 0), material_type::diffuse, path_tv);
+    scene.add_quad(point3(2, 0, -16), vec3(0, 0, -2), vec3(10, 0, 0), material_type::diffuse, path_tv);
 
     // EARTH /////////////////////////////////////////////////////////////////////////////
     // the earth
     texture_vector grass = texture_vector(51, 153, 51, 0, 0, 3);
-    scene.add_sphere(point3(0, -9999.9, 0), 9999.9, "diffuse", grass);
+    scene.add_sphere(point3(0, -9999.9, 0), 9999.9, material_type::diffuse, grass);
 
     // HOUSES ////////////////////////////////////////////////////////////////////////////
     // add houses
@@ -326,89 +326,93 @@ void final_render()
 
     // left three houses
     // left front ///////////////////////
-    scene.add_quad(point3(-3, 0, -1), vec3(0, 0, -5), vec3(0, 4, 0), "diffuse", house_tv);
-    scene.add_quad(point3(-3, 0, -1), vec3(-5, 0, 0), vec3(0, 4, 0), "diffuse", house_tv);
+    scene.add_quad(point3(-3, 0, -1), vec3(0, 0, -5), vec3(0, 4, 0), material_type::diffuse, house_tv);
+    scene.add_quad(point3(-3, 0, -1), vec3(-5, 0, 0), vec3(0, 4, 0), material_type::diffuse, house_tv);
 
     // door
-    scene.add_quad(point3(-3, 0, -2.5), vec3(0, 0, -1), vec3(0, 2, 0), "emissive", texture_vector(204, 204, 0));
+    scene.add_quad(point3(-3, 0, -2.5), vec3(0, 0, -1), vec3(0, 2, 0), material_type::emissive, texture_vector(204, 204, 0));
 
     /////////////////////////////////////////////////////////////////////////////////////////////////////
 
     // left middle ///////////////////////
-    scene.add_quad(point3(-3, 0, -10), vec3(0, 0, -5), vec3(0, 4, 0), "diffuse", house_tv);
-    scene.add_quad(point3(-3, 0, -10), vec3(-5, 0, 0), vec3(0, 4, 0), "diffuse", house_tv);
+    scene.add_quad(point3(-3, 0, -10), vec3(0, 0, -5), vec3(0, 4, 0), material_type::diffuse, house_tv);
+    scene.add_quad(point3(-3, 0, -10), vec3(-5, 0, 0), vec3(0, 4, 0), material_type::diffuse, house_tv);
 
     // door
-    scene.add_quad(point3(-3, 0, -11.5), vec3(0, 0, -1), vec3(0, 2, 0), "emissive", texture_vector(204, 204, 0));
+    scene.add_quad(point3(-3, 0, -11.5), vec3(0, 0, -1), vec3(0, 2, 0), material_type::emissive, texture_vector(204, 204, 0));
 
     /////////////////////////////////////////////////////////////////////////////////////////////////////
 
     // left back ///////////////////////
-    scene.add_quad(point3(-3, 0, -19), vec3(0, 0, -5), vec3(0, 4, 0), "diffuse", house_tv);
-    scene.add_quad(point3(-3, 0, -19), vec3(-5, 0, 0), vec3(0, 4, 0), "diffuse", house_tv);
+    scene.add_quad(point3(-3, 0, -19), vec3(0, 0, -5), vec3(0, 4, 0), material_type::diffuse, house_tv);
+    scene.add_quad(point3(-3, 0, -19), vec3(-5, 0, 0), vec3(0, 4, 0), material_type::diffuse, house_tv);
 
     // door
-    scene.add_quad(point3(-3, 0, -20.5), vec3(0, 0, -1), vec3(0, 2, 0), "emissive", texture_vector(204, 204, 0));
+    scene.add_quad(point3(-3, 0, -20.5), vec3(0, 0, -1), vec3(0, 2, 0), material_type::emissive, texture_vector(204, 204, 0));
 
     /////////////////////////////////////////////////////////////////////////////////////////////////////
 
     // right three houses
     // right front ///////////////////////
-    scene.add_quad(point3(3, 0, -1), vec3(0, 0, -5), vec3(0, 4, 0), "diffuse", house_tv);
-    scene.add_quad(point3(3, 0, -1), vec3(5, 0, 0), vec3(0, 4, 0), "diffuse", house_tv);
+    scene.add_quad(point3(3, 0, -1), vec3(0, 0, -5), vec3(0, 4, 0), material_type::diffuse, house_tv);
+    scene.add_quad(point3(3, 0, -1), vec3(5, 0, 0), vec3(0, 4, 0), material_type::diffuse, house_tv);
 
     // door
-    scene.add_quad(point3(3, 0, -2.5), vec3(0, 0, -1), vec3(0, 2, 0), "emissive", texture_vector(204, 204, 0));
+    scene.add_quad(point3(3, 0, -2.5), vec3(0, 0, -1), vec3(0, 2, 0), material_type::emissive, texture_vector(204, 204, 0));
 
     /////////////////////////////////////////////////////////////////////////////////////////////////////
 
     // right middle ///////////////////////
-    scene.add_quad(point3(3, 0, -10), vec3(0, 0, -5), vec3(0, 4, 0), "diffuse", house_tv);
-    scene.add_quad(point3(3, 0, -10), vec3(5, 0, 0), vec3(0, 4, 0), "diffuse", house_tv);
+    scene.add_quad(point3(3, 0, -10), vec3(0, 0, -5), vec3(0, 4, 0), material_type::diffuse, house_tv);
+    scene.add_quad(point3(3, 0, -10), vec3(5, 0, 0), vec3(0, 4, 0), material_type::diffuse, house_tv);
 
     // door
-    scene.add_quad(point3(3, 0, -11.5), vec3(0, 0, -1), vec3(0, 2, 0), "emissive", texture_vector(204, 204, 0));
+    scene.add_quad(point3(3, 0, -11.5), vec3(0, 0, -1), vec3(0, 2, 0), material_type::emissive, texture_vector(204, 204, 0));
 
     /////////////////////////////////////////////////////////////////////////////////////////////////////
 
     // right back ///////////////////////
-    scene.add_quad(point3(3, 0, -19), vec3(0, 0, -5), vec3(0, 4, 0), "diffuse", house_tv);
-    scene.add_quad(point3(3, 0, -19), vec3(5, 0, 0), vec3(0, 4, 0), "diffuse", house_tv);
+    scene.add_quad(point3(3, 0, -19), vec3(0, 0, -5), vec3(0, 4, 0), material_type::diffuse, house_tv);
+    scene.add_quad(point3(3, 0, -19), vec3(5, 0, 0), vec3(0, 4, 0), material_type::diffuse, house_tv);
 
     // door
-    scene.add_quad(point3(3, 0, -20.5), vec3(0, 0, -1), vec3(0, 2, 0), "emissive", texture_vector(204, 204, 0));
+    scene.add_quad(point3(3, 0, -20.5), vec3(0, 0, -1), vec3(0, 2, 0), material_type::emissive, texture_vector(204, 204, 0));
 
     /////////////////////////////////////////////////////////////////////////////////////////////////////
 
     // CASTLE /////////////////////////////////////////////////////////////////////////////
     // stand
-    scene.add_sphere(point3(0, -4, -40), 6, "diffuse", texture_vector(102, 51, 0));
+    scene.add_sphere(point3(0, -4, -40), 6, material_type::diffuse, texture_vector(102, 51, 0));
 
     // castle
     // add object
 
     // SKY ////////////////////////////////////////////////////////////////////////////////
     // sun
-    scene.add_sphere(point3(0, 55, -40), 30, "emissive", texture_vector(255, 255, 50));
+    scene.add_sphere(point3(0, 55, -40), 30, material_type::emissive, texture_vector(255, 255, 50));
 
     // PEOPLE //////////////////////////////////////////////////////////////////////////////
     // diffuse
-    scene.add_sphere(point3(0, 1, 0), 1, "diffuse", texture_vector(1));
-    scene.add_sphere(point3(-1, 1, -3), 1, "diffuse", texture_vector(0, 102, 0));
+    scene.add_sphere(point3(0, 1, 0), 1, material_type::diffuse, texture_vector(1));
+    scene.add_sphere(point3(-1, 1, -3), 1, material_type::diffuse, texture_vector(0, 102, 0));
 
     // custom
     auto cool_texture = make_shared<image_texture>("Textures/example-texture.png");
-    scene.add(make_shared<sphere>(point3(1, 1, -21), 1, cool_texture));
+    scene.add(make_shared<sphere>(point3(1, 1, -21), 1, make_shared<diffuse>(cool_texture)));
 
     // specular
-    scene.add_sphere(point3(0, 1, -11), 1, "specular", texture_vector(80, 80, 0));
-    scene.add_sphere(point3(1, 1, -30), 1, "specular", texture_vector(80, 80, 0));
+    scene.add_sphere(point3(0, 1, -11), 1, material_type::specular, texture_vector(80, 80, 0));
+    scene.add_sphere(point3(1, 1, -30), 1, material_type::specular, texture_vector(80, 80, 0));
 
     // dielectric
-    scene.add_sphere(point3(0, 1, 7), 0.7, "dielectric", texture_vector(0, 0, 0, 0, 0.67));
-    scene.add_sphere(point3(0, 1, 7), 1, "dielectric", texture_vector(0, 0, 0, 0, 1.5));
+    scene.add_sphere(point3(0, 1, 7), 0.7, material_type::dielectric, texture_vector(0, 0, 0, 0, 0.67));
+    scene.add_sphere(point3(0, 1, 7), 1, material_type::dielectric, texture_vector(0, 0, 0, 0, 1.5));
 
-    // render
+    // memory of the scene by category
+    debugger::getInstance().logToFile(scene.memory().report());
+
+    // render, checkpointing along the way (set cam.resume to pick up an interrupted run)
+    cam.checkpoint = true;
     cam.render(scene, "final-render.ppm");
 }
 
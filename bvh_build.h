@@ -0,0 +1,460 @@
+#ifndef BVH_BUILD_H
+#define BVH_BUILD_H
+
+// header file for the split selection shared by the bounding volume hierarchy builders
+
+// include
+#include "utility.h"
+#include "AA_bounding_box.h"
+
+// how the builder splits each node
+enum class bvh_build_quality
+{
+    // split at the object median along the longest axis of the node
+    median,
+    // binned surface area heuristic
+    sah
+};
+
+// bvh build settings
+struct bvh_build_settings
+{
+    bvh_build_quality quality = bvh_build_quality::sah;
+
+    // number of centroid bins per axis tested by the sah
+    int bin_count = 16;
+
+    // most objects the sah keeps in one leaf
+    int max_leaf_size = 4;
+
+    // cost of visiting an interior node and of one object intersection
+    double traversal_cost = 1.0;
+    double intersection_cost = 1.0;
+
+    // threads used by the build (0 uses every hardware thread, 1 builds serially)
+    int thread_count = 0;
+
+    // nodes with at least this many objects bin in parallel and hand one child subtree to another thread
+    size_t parallel_min_objects = 8192;
+};
+
+// numbers reported by a finished build
+struct bvh_build_stats
+{
+    double build_seconds = 0;
+    size_t node_count = 0;
+    size_t leaf_count = 0;
+    int depth = 0;
+    double sah_cost = 0;
+};
+
+// builder reference to one object
+struct bvh_primitive
+{
+    AA_bounding_box box;
+    point3 centroid;
+    size_t index;
+};
+
+// split chosen for a node
+struct bvh_split
+{
+    // keep every object of the node in one leaf
+    bool leaf;
+    // references [start, mid) go to the left child and [mid, end) to the right
+    size_t mid;
+    // axis the references were split along
+    int axis;
+    // box around every reference of the node
+    AA_bounding_box box;
+};
+
+// number of threads the build may use
+inline int bvh_build_threads(const bvh_build_settings &settings)
+{
+    int threads = settings.thread_count > 0 ? settings.thread_count : static_cast<int>(std::thread::hardware_concurrency());
+
+    return std::max(1, threads);
+}
+
+// smallest node that builds in parallel, at least 1 since chunk counts are divided by it
+inline size_t bvh_parallel_min_objects(const bvh_build_settings &settings)
+{
+    return std::max<size_t>(1, settings.parallel_min_objects);
+}
+
+// split [start, end) into even chunks and run work(chunk, begin, end) for each one on its own thread
+template <typename Work>
+void bvh_parallel_chunks(size_t start, size_t end, int chunks, Work &&work)
+{
+    chunks = std::max(1, chunks);
+    size_t step = (end - start + chunks - 1) / chunks;
+
+    std::vector<std::thread> workers;
+
+    for (int chunk = 1; chunk < chunks; chunk++)
+    {
+        size_t begin = std::min(end, start + chunk * step);
+        workers.emplace_back(work, chunk, begin, std::min(end, begin + step));
+    }
+
+    work(0, start, std::min(end, start + step));
+
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+// threads a build may still hand subtrees to
+class bvh_thread_budget
+{
+public:
+    // constructor with the threads the build may use, the calling thread included
+    bvh_thread_budget(int threads) : spare(threads - 1) {}
+
+    // take a thread if one is left
+    bool try_acquire()
+    {
+        int available = spare.load();
+
+        while (available > 0)
+        {
+            if (spare.compare_exchange_weak(available, available - 1))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // give a thread back
+    void release()
+    {
+        spare++;
+    }
+
+private:
+    std::atomic<int> spare;
+};
+
+// spare threads taken from a budget for as long as the lease lives
+class bvh_thread_lease
+{
+public:
+    // constructor taking up to wanted threads
+    bvh_thread_lease(bvh_thread_budget &budget, int wanted) : budget(budget)
+    {
+        while (threads < wanted && budget.try_acquire())
+        {
+            threads++;
+        }
+    }
+
+    bvh_thread_lease(const bvh_thread_lease &) = delete;
+    bvh_thread_lease &operator=(const bvh_thread_lease &) = delete;
+
+    ~bvh_thread_lease() { release(); }
+
+    // give the threads back early
+    void release()
+    {
+        for (; threads > 0; threads--)
+        {
+            budget.release();
+        }
+    }
+
+    // threads taken
+    int count() const { return threads; }
+
+private:
+    bvh_thread_budget &budget;
+    int threads = 0;
+};
+
+// build the two children of a node, the first one on another thread when the node is large and a thread is free
+template <typename Left, typename Right>
+void bvh_fork_join(bvh_thread_budget &budget, const bvh_build_settings &settings, size_t count, Left &&left, Right &&right)
+{
+    if (count >= settings.parallel_min_objects && budget.try_acquire())
+    {
+        std::thread worker(left);
+        right();
+        worker.join();
+        budget.release();
+        return;
+    }
+
+    left();
+    right();
+}
+
+// make the builder references for a list of objects
+template <typename Object>
+std::vector<bvh_primitive> make_bvh_primitives(const std::vector<shared_ptr<Object>> &objects, const bvh_build_settings &settings = bvh_build_settings())
+{
+    std::vector<bvh_primitive> refs(objects.size());
+
+    auto fill = [&](int, size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            refs[i].box = objects[i]->bounding_box();
+            refs[i].centroid = refs[i].box.centroid();
+            refs[i].index = i;
+        }
+    };
+
+    int chunks = static_cast<int>(std::min<size_t>(bvh_build_threads(settings), objects.size() / bvh_parallel_min_objects(settings) + 1));
+    bvh_parallel_chunks(0, objects.size(), chunks, fill);
+
+    return refs;
+}
+
+// expected cost of a node from the cost and box of its children
+inline double bvh_node_cost(const bvh_build_settings &settings, const AA_bounding_box &box,
+                            const AA_bounding_box &left_box, double left_cost,
+                            const AA_bounding_box &right_box, double right_cost)
+{
+    double area = box.surface_area();
+
+    if (area <= 0)
+    {
+        return settings.traversal_cost + left_cost + right_cost;
+    }
+
+    return settings.traversal_cost + (left_box.surface_area() * left_cost + right_box.surface_area() * right_cost) / area;
+}
+
+// split the references in [start, end) in two halves around their median centroid on the axis
+inline size_t bvh_median_partition(std::vector<bvh_primitive> &refs, size_t start, size_t end, int axis)
+{
+    size_t mid = start + (end - start) / 2;
+
+    std::nth_element(refs.begin() + start, refs.begin() + mid, refs.begin() + end,
+                     [axis](const bvh_primitive &a, const bvh_primitive &b)
+                     { return a.centroid[axis] < b.centroid[axis]; });
+
+    return mid;
+}
+
+// choose how to split the references in [start, end) and reorder them to match, binning on threads taken from the
+// build's budget so nodes binned inside forked subtrees never run more threads than the build was given
+inline bvh_split bvh_choose_split(std::vector<bvh_primitive> &refs, size_t start, size_t end, const bvh_build_settings &settings,
+                                  bvh_thread_budget &budget)
+{
+    size_t count = end - start;
+
+    if (count <= 1)
+    {
+        return {true, end, 0, count == 1 ? refs[start].box : AA_bounding_box::empty};
+    }
+
+    // large nodes near the root spread both passes over the references across the spare threads
+    int wanted = 1;
+
+    if (count >= settings.parallel_min_objects)
+    {
+        wanted = static_cast<int>(std::min<size_t>(bvh_build_threads(settings), count / (settings.parallel_min_objects / 2 + 1)));
+    }
+
+    bvh_thread_lease chunk_threads(budget, wanted - 1);
+    int chunks = 1 + chunk_threads.count();
+
+    // bounds of the centroids decide the split axis and the bins
+    // (small nodes are by far the most common, they use scratch space that is never allocated per node)
+    AA_bounding_box single_bounds[2];
+    std::vector<AA_bounding_box> chunk_bounds(chunks > 1 ? 2 * chunks : 0);
+    AA_bounding_box *bounds = chunks > 1 ? chunk_bounds.data() : single_bounds;
+
+    auto find_bounds = [&](int chunk, size_t begin, size_t finish)
+    {
+        AA_bounding_box centroids = AA_bounding_box::empty, boxes = AA_bounding_box::empty;
+
+        for (size_t i = begin; i < finish; i++)
+        {
+            centroids.enclose(refs[i].centroid);
+            boxes = AA_bounding_box(boxes, refs[i].box);
+        }
+
+        bounds[2 * chunk] = centroids;
+        bounds[2 * chunk + 1] = boxes;
+    };
+
+    bvh_parallel_chunks(start, end, chunks, find_bounds);
+
+    AA_bounding_box centroid_bounds = AA_bounding_box::empty, node_box = AA_bounding_box::empty;
+
+    for (int chunk = 0; chunk < chunks; chunk++)
+    {
+        centroid_bounds = AA_bounding_box(centroid_bounds, bounds[2 * chunk]);
+        node_box = AA_bounding_box(node_box, bounds[2 * chunk + 1]);
+    }
+
+    int longest = centroid_bounds.longest_axis();
+
+    // median split
+    if (settings.quality == bvh_build_quality::median)
+    {
+        return {false, bvh_median_partition(refs, start, end, longest), longest, node_box};
+    }
+
+    // every centroid in the same spot, no plane can separate them
+    if (centroid_bounds.axis_interval(longest).size() <= 0)
+    {
+        if (count <= size_t(settings.max_leaf_size))
+        {
+            return {true, end, longest, node_box};
+        }
+
+        return {false, start + count / 2, longest, node_box};
+    }
+
+    // bin the centroids on all three axes in one pass, each chunk into its own bins
+    // (no more bins than references, extra bins in a small node only add empty planes to sweep, and the setting is
+    // clamped before it meets the unsigned count so a bad value can not outgrow the fixed bin arrays)
+    const int max_bins = 64;
+    const int setting_bins = std::clamp(settings.bin_count, 2, max_bins);
+    const int bin_count = static_cast<int>(std::max<size_t>(2, std::min<size_t>(count, size_t(setting_bins))));
+
+    struct bin
+    {
+        AA_bounding_box box;
+        size_t count;
+    };
+
+    double scale[3];
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        const interval &extent = centroid_bounds.axis_interval(axis);
+        scale[axis] = extent.size() > 0 ? bin_count / extent.size() : 0;
+    }
+
+    auto bin_index = [&](const bvh_primitive &ref, int axis)
+    {
+        return std::min(bin_count - 1, int((ref.centroid[axis] - centroid_bounds.axis_interval(axis).min) * scale[axis]));
+    };
+
+    thread_local std::vector<bin> single_bins(3 * max_bins);
+    std::vector<bin> chunk_bins(chunks > 1 ? size_t(chunks) * 3 * bin_count : 0);
+    bin *all_bins = chunks > 1 ? chunk_bins.data() : single_bins.data();
+
+    auto fill_bins = [&](int chunk, size_t begin, size_t finish)
+    {
+        bin *bins = all_bins + size_t(chunk) * 3 * bin_count;
+
+        for (int i = 0; i < 3 * bin_count; i++)
+        {
+            bins[i] = {AA_bounding_box::empty, 0};
+        }
+
+        for (size_t i = begin; i < finish; i++)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                bin &b = bins[axis * bin_count + bin_index(refs[i], axis)];
+                b.box = AA_bounding_box(b.box, refs[i].box);
+                b.count++;
+            }
+        }
+    };
+
+    bvh_parallel_chunks(start, end, chunks, fill_bins);
+    chunk_threads.release();
+
+    bin *bins = all_bins;
+
+    for (int chunk = 1; chunk < chunks; chunk++)
+    {
+        const bin *other = all_bins + size_t(chunk) * 3 * bin_count;
+
+        for (int i = 0; i < 3 * bin_count; i++)
+        {
+            bins[i].box = AA_bounding_box(bins[i].box, other[i].box);
+            bins[i].count += other[i].count;
+        }
+    }
+
+    // sweep the bin boundaries of every axis for the cheapest plane
+    double right_cost[max_bins];
+    double node_area = node_box.surface_area();
+    double best_cost = infinity;
+    int best_axis = -1, best_plane = 0;
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if (scale[axis] <= 0)
+        {
+            continue;
+        }
+
+        const bin *axis_bins = &bins[axis * bin_count];
+
+        // right to left sweep stores the area times count of everything right of each plane
+        AA_bounding_box sweep_box = AA_bounding_box::empty;
+        size_t sweep_count = 0;
+
+        for (int plane = bin_count - 1; plane > 0; plane--)
+        {
+            sweep_box = AA_bounding_box(sweep_box, axis_bins[plane].box);
+            sweep_count += axis_bins[plane].count;
+            right_cost[plane] = sweep_box.surface_area() * sweep_count;
+        }
+
+        // left to right sweep finishes the cost of each plane
+        sweep_box = AA_bounding_box::empty;
+        sweep_count = 0;
+
+        for (int plane = 1; plane < bin_count; plane++)
+        {
+            sweep_box = AA_bounding_box(sweep_box, axis_bins[plane - 1].box);
+            sweep_count += axis_bins[plane - 1].count;
+
+            if (sweep_count == 0 || sweep_count == count)
+            {
+                continue;
+            }
+
+            double cost = settings.traversal_cost + settings.intersection_cost * (sweep_box.surface_area() * sweep_count + right_cost[plane]) / node_area;
+
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                best_axis = axis;
+                best_plane = plane;
+            }
+        }
+    }
+
+    // a leaf wins when it is small enough and no split is cheaper than testing every object
+    double leaf_cost = settings.intersection_cost * count;
+
+    if (count <= size_t(settings.max_leaf_size) && (best_axis < 0 || leaf_cost <= best_cost))
+    {
+        return {true, end, longest, node_box};
+    }
+
+    if (best_axis < 0)
+    {
+        return {false, bvh_median_partition(refs, start, end, longest), longest, node_box};
+    }
+
+    // move the references to their side of the chosen plane
+    auto middle = std::partition(refs.begin() + start, refs.begin() + end,
+                                 [&](const bvh_primitive &ref)
+                                 { return bin_index(ref, best_axis) < best_plane; });
+
+    size_t mid = size_t(middle - refs.begin());
+
+    if (mid == start || mid == end)
+    {
+        mid = bvh_median_partition(refs, start, end, best_axis);
+    }
+
+    return {false, mid, best_axis, node_box};
+}
+
+#endif
@@ -0,0 +1,245 @@
+#ifndef BVH_CACHE_H
+#define BVH_CACHE_H
+
+// header file for the on-disk cache of built linear_bvh hierarchies, keyed by a hash of the primitive boxes and the
+// build settings (the only inputs the builder looks at, so equal keys always mean equal trees)
+
+// include
+#include "utility.h"
+#include "linear_bvh.h"
+#include "mapped_file.h"
+
+#include <filesystem>
+
+// name for a temporary file next to filename, different for every writer so renders saving the same cache file at
+// once never write into each other's temporary file
+inline std::string cache_temp_name(const std::string &filename)
+{
+    static std::atomic<uint64_t> counter{0};
+    std::random_device device;
+
+    uint64_t tag = hash_combine(device(), device());
+    tag = hash_combine(tag, uint64_t(std::chrono::steady_clock::now().time_since_epoch().count()));
+    tag = hash_combine(tag, std::hash<std::thread::id>()(std::this_thread::get_id()));
+    tag = hash_combine(tag, counter++);
+
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), ".%016llx.tmp", static_cast<unsigned long long>(tag));
+
+    return filename + suffix;
+}
+
+// write head then payload to a temporary file and move it into place, so readers never see half a file
+inline void write_cache_file(const std::string &filename, const void *head, size_t head_size, const unsigned char *payload, size_t payload_size)
+{
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(filename).parent_path(), error);
+
+    std::string temp_filename = cache_temp_name(filename);
+    std::ofstream out(temp_filename, std::ios::binary | std::ios::trunc);
+
+    if (!out)
+    {
+        debugger::getInstance().logToFile("Could not write cache file " + temp_filename);
+        return;
+    }
+
+    out.write(reinterpret_cast<const char *>(head), head_size);
+    out.write(reinterpret_cast<const char *>(payload), payload_size);
+    out.close();
+
+    if (!out)
+    {
+        std::filesystem::remove(temp_filename, error);
+        return;
+    }
+
+    std::filesystem::rename(temp_filename, filename, error);
+
+    if (error)
+    {
+        std::filesystem::remove(temp_filename, error);
+    }
+}
+
+// bvh_cache
+class bvh_cache
+{
+public:
+    // turn the cache on or off
+    bool enabled = true;
+
+    // folder the cache files are kept in
+    std::string directory = "Cache";
+
+    // hierarchies over fewer primitives build faster than they load, so they are never cached
+    size_t min_primitives = 50000;
+
+    // bump when the file layout or the builder output changes
+    static const uint32_t version = 1;
+
+    // fill bvh from the cache if a file for these references and settings exists, else build it and store it
+    // returns true when the hierarchy came from disk
+    bool build(linear_bvh &bvh, std::vector<bvh_primitive> &refs, const bvh_build_settings &settings) const
+    {
+        if (!enabled || refs.size() < min_primitives)
+        {
+            bvh.build(refs, settings);
+            return false;
+        }
+
+        auto load_start = std::chrono::steady_clock::now();
+        uint64_t hash = key(refs, settings);
+        std::string filename = file_for(hash);
+
+        if (load(filename, hash, refs.size(), bvh, settings))
+        {
+            bvh.stats.build_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - load_start).count();
+            return true;
+        }
+
+        bvh.build(refs, settings);
+        save(filename, hash, bvh);
+
+        return false;
+    }
+
+    // hash of the primitive boxes, their order, and every setting that changes the tree
+    static uint64_t key(const std::vector<bvh_primitive> &refs, const bvh_build_settings &settings)
+    {
+        uint64_t hash = hash_mix(0x6a09e667f3bcc908ULL ^ version);
+
+        auto add = [&hash](double value)
+        {
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            hash = hash_mix(hash ^ bits);
+        };
+
+        add(double(sizeof(linear_bvh_node)));
+        add(double(refs.size()));
+        add(double(settings.quality == bvh_build_quality::sah));
+        add(settings.bin_count);
+        add(settings.max_leaf_size);
+        add(settings.traversal_cost);
+        add(settings.intersection_cost);
+
+        for (const auto &ref : refs)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                add(ref.box.axis_interval(axis).min);
+                add(ref.box.axis_interval(axis).max);
+            }
+        }
+
+        return hash;
+    }
+
+    // cache file for a key
+    std::string file_for(uint64_t hash) const
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "bvh-%016llx.bin", static_cast<unsigned long long>(hash));
+
+        return directory + "/" + name;
+    }
+
+private:
+    // file header, followed by the nodes and then the primitive indices
+    struct header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t node_size;
+        uint64_t key;
+        uint64_t node_count;
+        uint64_t primitive_count;
+        uint64_t checksum;
+    };
+
+    // map the file and copy the hierarchy out of it, refusing anything that does not match or is damaged
+    static bool load(const std::string &filename, uint64_t hash, size_t primitive_count, linear_bvh &bvh, const bvh_build_settings &settings)
+    {
+        mapped_file file(filename);
+
+        if (!file.is_open() || file.size() < sizeof(header))
+        {
+            return false;
+        }
+
+        header h;
+        std::memcpy(&h, file.data(), sizeof(h));
+
+        if (std::memcmp(h.magic, "RTBVHC01", 8) != 0 || h.version != version || h.node_size != sizeof(linear_bvh_node) ||
+            h.key != hash || h.primitive_count != primitive_count || h.node_count == 0 ||
+            file.size() != sizeof(header) + h.node_count * sizeof(linear_bvh_node) + h.primitive_count * sizeof(uint32_t))
+        {
+            return false;
+        }
+
+        if (hash_bytes(file.data() + sizeof(header), file.size() - sizeof(header)) != h.checksum)
+        {
+            return false;
+        }
+
+        const linear_bvh_node *nodes = reinterpret_cast<const linear_bvh_node *>(file.data() + sizeof(header));
+        const uint32_t *indices = reinterpret_cast<const uint32_t *>(file.data() + sizeof(header) + h.node_count * sizeof(linear_bvh_node));
+
+        // every child, split axis, leaf range and primitive must stay in bounds, so a file written by a broken build can
+        // never crash a render
+        for (uint64_t i = 0; i < h.node_count; i++)
+        {
+            const linear_bvh_node &node = nodes[i];
+            bool in_bounds = node.count > 0 ? uint64_t(node.offset) + node.count <= h.primitive_count
+                                            : node.offset > i + 1 && node.offset < h.node_count && node.axis < 3;
+
+            if (!in_bounds)
+            {
+                return false;
+            }
+        }
+
+        for (uint64_t i = 0; i < h.primitive_count; i++)
+        {
+            if (indices[i] >= h.primitive_count)
+            {
+                return false;
+            }
+        }
+
+        bvh.assign(nodes, h.node_count, indices, h.primitive_count, settings);
+
+        // traversal keeps one stack slot per level
+        if (bvh.stats.depth > linear_bvh::max_depth)
+        {
+            bvh = linear_bvh();
+            return false;
+        }
+
+        return true;
+    }
+
+    // write the hierarchy to the cache file
+    static void save(const std::string &filename, uint64_t hash, const linear_bvh &bvh)
+    {
+        header h;
+        std::memcpy(h.magic, "RTBVHC01", 8);
+        h.version = version;
+        h.node_size = sizeof(linear_bvh_node);
+        h.key = hash;
+        h.node_count = bvh.nodes.size();
+        h.primitive_count = bvh.primitive_indices.size();
+
+        size_t node_bytes = bvh.nodes.size() * sizeof(linear_bvh_node);
+        size_t index_bytes = bvh.primitive_indices.size() * sizeof(uint32_t);
+        std::vector<unsigned char> payload(node_bytes + index_bytes);
+        std::memcpy(payload.data(), bvh.nodes.data(), node_bytes);
+        std::memcpy(payload.data() + node_bytes, bvh.primitive_indices.data(), index_bytes);
+        h.checksum = hash_bytes(payload.data(), payload.size());
+
+        write_cache_file(filename, &h, sizeof(h), payload.data(), payload.size());
+    }
+};
+
+#endif
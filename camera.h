@@ -1,11 +1,169 @@
 #ifndef CAMERA_H
 #define CAMERA_H
 
-// header file for the camera class that actual renders the world and creates the ppm file
+// header file for the camera class that actual renders the world and creates the image file
 
 // include
 #include "utility.h"
 #include "material.h"
+#include "accumulation_buffer.h"
+#include "checkpoint.h"
+
+// when a progressive render stops, and how often it writes what it has so far (0 turns a limit off, with every limit
+// off the render stops at 100 samples per pixel like a plain render)
+struct progressive_settings
+{
+    // samples added to every pixel by one pass
+    int samples_per_pass = 4;
+
+    // stop once every pixel has this many samples (with adaptive sampling, once the image has taken this many samples
+    // per pixel on average)
+    int target_samples = 100;
+
+    // stop after this many seconds of rendering, the pass running at the deadline stops handing out tiles
+    double time_budget = 0;
+
+    // stop once the mean relative standard error of the pixels falls below this
+    double noise_threshold = 0;
+
+    // write the image again when this many seconds have passed since the last write
+    double write_interval = 0;
+
+    // draw one tile progress bar across all the passes the target needs, in place of the status line of every pass
+    bool show_progress = false;
+};
+
+// per pixel sample counts driven by the noise of each pixel
+struct adaptive_settings
+{
+    // let pixels stop early once they are smooth enough and spend the samples they leave of the target on the pixels
+    // that are still noisy (off by default so a plain render keeps its fixed samples)
+    bool enabled = false;
+
+    // samples every pixel takes before it may stop
+    int min_samples = 32;
+
+    // most samples one pixel may take, noisy pixels go past the target up to here (0 keeps them at the target)
+    int max_samples = 1024;
+
+    // a pixel stops once the 95% confidence interval of its mean luminance is within this fraction of the mean
+    double tolerance = 0.05;
+};
+
+// numbers reported by a finished render
+struct render_stats
+{
+    int passes = 0;
+    uint32_t min_samples = 0;
+    uint64_t samples = 0;
+    double seconds = 0;
+    double noise = 0;
+
+    // rays traced, and paths that ended after each number of rays (index 0 is unused)
+    uint64_t rays = 0;
+    std::vector<uint64_t> path_depths;
+
+    // paths ended by russian roulette rather than by a miss, an absorbing hit, or the depth limit, in all and after
+    // each number of rays
+    uint64_t roulette_ends = 0;
+    std::vector<uint64_t> roulette_depths;
+
+    // rays cast toward sampled lights
+    uint64_t light_rays = 0;
+
+    // rays per path
+    double mean_depth() const
+    {
+        uint64_t paths = 0;
+
+        for (uint64_t count : path_depths)
+        {
+            paths += count;
+        }
+
+        return paths > 0 ? double(rays) / paths : 0;
+    }
+
+    // rays a path takes at most with the given fraction of paths as short or shorter
+    int depth_percentile(double fraction) const
+    {
+        uint64_t paths = 0, seen = 0;
+
+        for (uint64_t count : path_depths)
+        {
+            paths += count;
+        }
+
+        for (size_t depth = 1; depth < path_depths.size(); depth++)
+        {
+            seen += path_depths[depth];
+
+            if (paths > 0 && double(seen) >= fraction * paths)
+            {
+                return int(depth);
+            }
+        }
+
+        return int(path_depths.empty() ? 0 : path_depths.size() - 1);
+    }
+
+    // estimate of the rays roulette saved, every path it ended at some depth would have gone on for as many more rays
+    // as the paths that got past that depth took on average (those were cut short by roulette too, so this is a low
+    // estimate)
+    double roulette_rays_saved() const
+    {
+        double saved = 0;
+
+        for (size_t depth = 1; depth < roulette_depths.size(); depth++)
+        {
+            if (roulette_depths[depth] == 0)
+            {
+                continue;
+            }
+
+            uint64_t longer = 0, more_rays = 0;
+
+            for (size_t deeper = depth + 1; deeper < path_depths.size(); deeper++)
+            {
+                longer += path_depths[deeper];
+                more_rays += (deeper - depth) * path_depths[deeper];
+            }
+
+            if (longer > 0)
+            {
+                saved += double(roulette_depths[depth]) * more_rays / longer;
+            }
+        }
+
+        return saved;
+    }
+
+    // add the path counts of another render or tile
+    void add_paths(const render_stats &other)
+    {
+        add_counts(path_depths, other.path_depths);
+        add_counts(roulette_depths, other.roulette_depths);
+
+        rays += other.rays;
+        roulette_ends += other.roulette_ends;
+        light_rays += other.light_rays;
+    }
+
+private:
+    // add counts per depth into to
+    static void add_counts(std::vector<uint64_t> &to, const std::vector<uint64_t> &from)
+    {
+        if (to.size() < from.size())
+        {
+            to.resize(from.size(), 0);
+        }
+
+        for (size_t depth = 0; depth < from.size(); depth++)
+        {
+            to[depth] += from[depth];
+        }
+    }
+};
 
 // camera
 class camera
@@ -19,6 +177,47 @@ public:
     point3 center;
     bool is_configured = false;
 
+    // render threads (0 uses every hardware thread, 1 renders serially on the calling thread)
+    int thread_count = 0;
+
+    // width and height in pixels of the square tiles handed out to the render threads
+    int tile_size = 32;
+
+    // seed of the render, every pixel draws its own random stream from it
+    uint64_t seed = 0;
+
+    // linear radiance sum and sample count of every pixel, the main output of a render
+    accumulation_buffer accumulation;
+
+    // add the samples of the next render to the accumulation buffer instead of starting over (same image size only)
+    bool accumulate = false;
+
+    // display transform used when writing 8 bit images
+    tonemap_settings tonemap;
+
+    // adaptive sampling for anti aliased and progressive renders (turn on to move samples from smooth pixels to noisy
+    // ones)
+    adaptive_settings adaptive;
+
+    // bounces a path may take before it is cut off
+    int max_depth = 50;
+
+    // after roulette_depth bounces, end paths at random with a chance that grows as their throughput falls, and
+    // weight the survivors up so the image stays unbiased
+    bool roulette = true;
+    int roulette_depth = 3;
+
+    // at every diffuse or volume hit, also cast a ray toward a point on one of the world's lights, and weigh it
+    // against the scattered ray with multiple importance sampling (small lights converge much faster)
+    bool sample_lights = true;
+
+    // save the accumulation buffer of progressive renders next to the image every checkpoint_interval seconds
+    bool checkpoint = false;
+    double checkpoint_interval = 60;
+
+    // carry on from the checkpoint of the same image, if it was written for this scene, camera, and seed
+    bool resume = false;
+
     // camera constructor to set the width, height, and background color
     camera(int width = 400, int height = 225, color bg = color(0.70, 0.80, 1.00))
     {
@@ -60,59 +259,278 @@ public:
             return;
         }
 
-        // path to render
-        std::string path = "Renders";
-        std::string filepath = path + "/" + output_filename;
-
-        // open the file for writing
-        std::ofstream outFile(filepath);
-        if (!outFile)
+        // with adaptive sampling, the 100 samples per pixel become a budget for the whole image that smooth pixels leave
+        // to the noisy ones, and checkpoints are written by the progressive passes
+        if (anti && (adaptive.enabled || checkpoint || resume))
         {
-            std::cerr << "Error: Could not open the file for writing!" << std::endl;
+            progressive_settings settings;
+            settings.samples_per_pass = 8;
+            settings.target_samples = 100;
+            settings.show_progress = true;
+
+            render_progressive(world, output_filename, settings);
             return;
         }
 
-        // PPM header
-        outFile << "P3\n"
-                << image_width << ' ' << image_height << "\n255\n";
+        if (!accumulate || accumulation.width != image_width || accumulation.height != image_height)
+        {
+            accumulation.reset(image_width, image_height);
+        }
+
+        // render every tile into the accumulation buffer, then tonemap, encode and write it in one go
+        // the calling thread renders too, so keep its generator for whatever runs after the render
+        pcg32 caller_rng = thread_rng();
+        render_stats stats;
 
-        // double for loop to go over all image pixels
-        for (int j = 0; j < image_height; j++)
+        render_tiles(world, (anti ? 100 : 1), no_cap, no_deadline(), no_budget, true, stats);
+
+        thread_rng() = caller_rng;
+
+        if (write_image(output_filename))
         {
-            for (int i = 0; i < image_width; i++)
+            std::cout << "\n Render Completed in " << "Renders/" + output_filename << "\n";
+            print_path_stats(stats);
+        }
+    }
+
+    // render the whole image in passes of a few samples per pixel until the target samples, the time budget, or the
+    // noise threshold is reached, writing the image along the way so there is always something to look at
+    // (with adaptive sampling, pixels that are smooth enough drop out, and the samples per pixel of the target are an
+    // image wide budget that the noisy ones keep spending, each up to adaptive.max_samples)
+    render_stats render_progressive(const hittable &world, std::string output_filename, const progressive_settings &settings = progressive_settings())
+    {
+        render_stats stats;
+
+        // make sure camera is configured
+        if (!is_configured)
+        {
+            std::cerr << "Camera Not Configured" << std::endl;
+            return stats;
+        }
+
+        if (!accumulate || accumulation.width != image_width || accumulation.height != image_height)
+        {
+            accumulation.reset(image_width, image_height);
+        }
+
+        uint32_t cap = settings.target_samples > 0 ? uint32_t(settings.target_samples) : no_cap;
+
+        // nothing would ever stop the passes, so cap them like a plain anti aliased render
+        if (cap == no_cap && settings.time_budget <= 0 && settings.noise_threshold <= 0)
+        {
+            debugger::getInstance().logToFile("Progressive render of " + output_filename + " has no target, time budget, or noise threshold, stopping at 100 samples per pixel");
+            cap = 100;
+        }
+
+        double pixel_count = double(image_width) * image_height;
+
+        // adaptive sampling turns the target into samples for the whole image, and the cap of a pixel into the
+        // ceiling of adaptive settings
+        uint64_t budget = no_budget;
+
+        if (adaptive.enabled && adaptive.max_samples > 0)
+        {
+            if (cap != no_cap)
             {
-                color pixel_color(0, 0, 0);
-                int sample_count = (anti ? 100 : 1);
+                budget = uint64_t(cap) * uint64_t(image_width) * uint64_t(image_height);
+            }
 
-                for (int sample = 0; sample < sample_count; sample++)
-                {
-                    try
-                    {
-                        ray r = get_ray(i, j);
-                        pixel_color += ray_color(r, 50, world);
-                    }
+            cap = cap == no_cap ? uint32_t(adaptive.max_samples) : std::max(cap, uint32_t(adaptive.max_samples));
+        }
 
-                    catch (const std::exception &e)
-                    {
-                        debugger::getInstance().logToFile(e.what());
-                    }
-                }
+        std::string checkpoint_file = "Renders/" + output_filename + ".checkpoint";
+        uint64_t scene_fingerprint = (checkpoint || resume) ? fingerprint(world) : 0;
+
+        if (resume)
+        {
+            // a checkpoint that already reached the target would only write the old image again
+            if (render_checkpoint::load(checkpoint_file, accumulation, seed, scene_fingerprint) &&
+                accumulation.width == image_width && accumulation.height == image_height && !finished(cap, budget))
+            {
+                std::cout << " Resuming from " << checkpoint_file << " at " << accumulation.min_samples() << " samples per pixel\n";
+            }
+
+            else
+            {
+                accumulation.reset(image_width, image_height);
+                debugger::getInstance().logToFile("No unfinished checkpoint " + checkpoint_file + " for this render, starting over");
+            }
+        }
 
-                try
+        auto start = std::chrono::steady_clock::now();
+        auto last_write = start;
+        auto last_checkpoint = start;
+        auto deadline = settings.time_budget > 0 ? start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(settings.time_budget))
+                                                 : no_deadline();
+        int pass_samples = std::max(1, settings.samples_per_pass);
+
+        // passes the progress bar is spread over, none without a target (a budget is drawn by the samples it spent
+        // after every pass instead, the passes it takes are not known up front)
+        int bar_passes = 0;
+        uint32_t start_samples = accumulation.min_samples();
+        uint64_t spent = budget != no_budget ? accumulation.total_samples() : 0;
+        bool budget_bar = settings.show_progress && budget != no_budget;
+
+        if (settings.show_progress && budget == no_budget && cap != no_cap && start_samples < cap)
+        {
+            bar_passes = static_cast<int>((cap - start_samples + pass_samples - 1) / pass_samples);
+        }
+
+        pcg32 caller_rng = thread_rng();
+
+        while (true)
+        {
+            // a pass that finds nothing left to sample means every pixel is at the target or done, or the budget is spent
+            uint64_t remaining = budget != no_budget ? budget - std::min(budget, spent) : no_budget;
+            uint64_t taken = render_tiles(world, pass_samples, cap, deadline, remaining, stats.passes < bar_passes, stats, stats.passes, bar_passes);
+
+            if (taken == 0)
+            {
+                // adaptive sampling can finish every pixel before the last pass the bar counted on
+                if (bar_passes > 0 || budget_bar)
                 {
-                    write_color(outFile, (1.0 / sample_count) * pixel_color);
+                    print_progress_bar(1, 1);
                 }
 
-                catch (const std::exception &e)
+                break;
+            }
+
+            spent += taken;
+
+            stats.passes++;
+            stats.samples += taken;
+
+            auto now = std::chrono::steady_clock::now();
+            stats.seconds = std::chrono::duration<double>(now - start).count();
+            stats.min_samples = accumulation.min_samples();
+
+            if (settings.noise_threshold > 0)
+            {
+                stats.noise = accumulation.mean_relative_error();
+            }
+
+            if (budget_bar)
+            {
+                print_progress_bar(static_cast<int>(1000 * std::min(spent, budget) / budget), 1000);
+            }
+
+            else if (bar_passes == 0)
+            {
+                std::cout << "\r pass " << stats.passes << ", " << stats.samples / pixel_count << " samples per pixel, " << stats.seconds << "s";
+
+                if (settings.noise_threshold > 0)
                 {
-                    debugger::getInstance().logToFile(e.what());
+                    std::cout << ", noise " << stats.noise;
                 }
+
+                std::cout.flush();
+            }
+
+            if (now >= deadline || (settings.noise_threshold > 0 && stats.noise < settings.noise_threshold))
+            {
+                break;
+            }
+
+            if (settings.write_interval > 0 && std::chrono::duration<double>(now - last_write).count() >= settings.write_interval)
+            {
+                write_image(output_filename);
+                last_write = now;
             }
 
-            print_progress_bar(j, image_height);
+            if (checkpoint && std::chrono::duration<double>(now - last_checkpoint).count() >= checkpoint_interval)
+            {
+                render_checkpoint::save(checkpoint_file, accumulation, seed, scene_fingerprint);
+                last_checkpoint = now;
+            }
         }
 
-        std::cout << "\n Render Completed in " << filepath << "\n";
+        thread_rng() = caller_rng;
+
+        // the final checkpoint lets a finished render be resumed with a higher target
+        if (checkpoint)
+        {
+            render_checkpoint::save(checkpoint_file, accumulation, seed, scene_fingerprint);
+        }
+
+        if (write_image(output_filename))
+        {
+            std::cout << "\n Render Completed in " << "Renders/" + output_filename << "\n";
+            print_path_stats(stats);
+        }
+
+        return stats;
+    }
+
+    // write the mean of the accumulation buffer to the Renders folder, the extension picks the format (.ppm, .png, or .exr)
+    bool write_image(const std::string &output_filename) const
+    {
+        // path to render
+        std::string path = "Renders";
+        std::string filepath = path + "/" + output_filename;
+
+        if (!image_writer::write(filepath, accumulation.resolve(), tonemap))
+        {
+            std::cerr << "Error: Could not open the file for writing!" << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    // print the rays traced, the mean path depth and its spread, how many paths roulette ended, and the rays and time
+    // that saved
+    void print_path_stats(const render_stats &stats) const
+    {
+        uint64_t paths = 0;
+
+        for (uint64_t count : stats.path_depths)
+        {
+            paths += count;
+        }
+
+        if (paths == 0)
+        {
+            return;
+        }
+
+        std::cout << " " << stats.rays << " rays, " << stats.mean_depth() << " per path, "
+                  << 100.0 * stats.roulette_ends / paths << "% of paths ended by roulette, " << stats.light_rays << " light rays\n";
+
+        std::cout << " path depth median " << stats.depth_percentile(0.5) << ", 90% " << stats.depth_percentile(0.9)
+                  << ", 99% " << stats.depth_percentile(0.99) << ", longest " << stats.depth_percentile(1.0) << "\n";
+
+        // the light rays do not change with roulette, so they count toward the rays either way
+        if (stats.roulette_ends > 0)
+        {
+            double saved = stats.roulette_rays_saved();
+            double traced = double(stats.rays + stats.light_rays);
+
+            std::cout << " roulette saved about " << uint64_t(saved) << " rays, without it the render would trace about " << (traced + saved) / traced << "x the rays\n";
+        }
+    }
+
+    // hash of the image size, the view, the background, the path tracing and adaptive settings, and the geometry,
+    // materials, and textures of the world, a checkpoint only fits the render with the same fingerprint
+    uint64_t fingerprint(const hittable &world) const
+    {
+        uint64_t hash = hash_combine(uint64_t(image_width), uint64_t(image_height));
+        const vec3 view[] = {center, upper_left_pixel, vec_del_u, vec_del_v, background};
+
+        for (const vec3 &v : view)
+        {
+            hash = hash_double(hash_double(hash_double(hash, v.x()), v.y()), v.z());
+        }
+
+        hash = hash_combine(hash, uint64_t(max_depth));
+        hash = hash_combine(hash, uint64_t(roulette));
+        hash = hash_combine(hash, uint64_t(roulette_depth));
+        hash = hash_combine(hash, uint64_t(sample_lights));
+        hash = hash_combine(hash, uint64_t(adaptive.enabled));
+        hash = hash_combine(hash, uint64_t(adaptive.min_samples));
+        hash = hash_combine(hash, uint64_t(adaptive.max_samples));
+        hash = hash_double(hash, adaptive.tolerance);
+
+        return hash_combine(hash, world.fingerprint());
     }
 
 private:
@@ -132,40 +550,283 @@ private:
         return ray(ray_origin, ray_direction, ray_time);
     }
 
-    // function to get the ray color
-    color ray_color(const ray &r, int depth, const hittable &world) const
+    // function to get the ray color, following the path bounce by bounce with the running throughput and radiance
+    // instead of recursing, so a deep path costs no stack, and counting the rays it took in paths
+    color ray_color(ray r, const hittable &world, render_stats &paths) const
     {
+        color radiance(0, 0, 0);
+        color throughput(1, 1, 1);
+        place_hit rec, light_rec;
         ray scattered;
         color attenuation;
+        int depth = 0;
 
-        if (depth <= 0)
+        // pdf of the scatter that led to the current ray, 0 for camera rays and mirror like bounces whose light
+        // cannot also have been found by a light sample
+        double scatter_pdf = 0;
+        point3 scatter_origin;
+
+        while (depth < max_depth)
         {
-            return color(0, 0, 0);
+            depth++;
+
+            if (!world.intersect(r, interval(0.001, infinity), rec))
+            {
+                radiance += throughput * background;
+                break;
+            }
+
+            // only the closest hit gets its point, normal, and material
+            rec.finish(r);
+
+            color emission = material_emitted(*rec.mat, rec.u, rec.v, rec.p);
+
+            // light the previous hit also sampled directly only counts with its share of the two strategies
+            if (scatter_pdf > 0 && sample_lights && (emission.x() > 0 || emission.y() > 0 || emission.z() > 0))
+            {
+                emission = emission * power_heuristic(scatter_pdf, world.pdf_value(scatter_origin, r.direction(), r.time()));
+            }
+
+            radiance += throughput * emission;
+
+            if (!material_scatter(*rec.mat, r, rec, attenuation, scattered))
+            {
+                break;
+            }
+
+            scatter_pdf = material_scattering_pdf(*rec.mat, r, rec, scattered);
+            scatter_origin = rec.p;
+
+            // next event estimation, the light seen along a direction picked toward the lights
+            if (scatter_pdf > 0 && sample_lights)
+            {
+                ray to_light(rec.p, world.random(rec.p, r.time()), r.time());
+                double light_pdf = world.pdf_value(rec.p, to_light.direction(), to_light.time());
+                double material_pdf = light_pdf > 0 ? material_scattering_pdf(*rec.mat, r, rec, to_light) : 0;
+
+                if (material_pdf > 0)
+                {
+                    paths.light_rays++;
+
+                    if (world.intersect(to_light, interval(0.001, infinity), light_rec))
+                    {
+                        light_rec.finish(to_light);
+
+                        color light = material_emitted(*light_rec.mat, light_rec.u, light_rec.v, light_rec.p);
+                        double weight = power_heuristic(light_pdf, material_pdf) * material_pdf / light_pdf;
+
+                        radiance += throughput * attenuation * light * weight;
+                    }
+                }
+            }
+
+            throughput = throughput * attenuation;
+            r = scattered;
+
+            // survive with the largest throughput channel as the probability, a path that keeps little light
+            // rarely costs more rays, and the ones that go on carry the light of the ones that stopped
+            if (roulette && depth >= roulette_depth)
+            {
+                double survive = std::min(1.0, std::max(throughput.x(), std::max(throughput.y(), throughput.z())));
+
+                if (random_double() >= survive)
+                {
+                    paths.roulette_ends++;
+                    paths.roulette_depths[depth]++;
+                    break;
+                }
+
+                throughput = throughput / survive;
+            }
         }
 
-        place_hit rec;
+        paths.rays += depth;
+        paths.path_depths[depth]++;
+
+        return radiance;
+    }
+
+    // weight of a sample taken with pdf when another strategy could have taken it with other_pdf
+    static double power_heuristic(double pdf, double other_pdf)
+    {
+        return pdf * pdf / (pdf * pdf + other_pdf * other_pdf);
+    }
+
+    // sample cap of renders without a target
+    static const uint32_t no_cap = std::numeric_limits<uint32_t>::max();
 
-        if (!world.intersect(r, interval(0.001, infinity), rec))
+    // sample budget of renders that do not share samples out over the image
+    static const uint64_t no_budget = std::numeric_limits<uint64_t>::max();
+
+    // deadline of renders without a time budget
+    static std::chrono::steady_clock::time_point no_deadline()
+    {
+        return std::chrono::steady_clock::time_point::max();
+    }
+
+    // region of the image rendered as one unit of work
+    struct tile
+    {
+        int x0, y0, x1, y1;
+    };
+
+    // split the image into tiles and render them on a pool of threads, adding their rays and path depths to stats
+    // tiles are no longer handed out once the deadline has passed or budget samples were taken, returns the number of
+    // samples taken (the progress bar counts this as pass number pass of passes)
+    uint64_t render_tiles(const hittable &world, int samples, uint32_t cap, std::chrono::steady_clock::time_point deadline, uint64_t budget, bool show_progress, render_stats &stats, int pass = 0, int passes = 1)
+    {
+        std::vector<tile> tiles;
+        int size = std::max(tile_size, 1);
+
+        for (int y = 0; y < image_height; y += size)
         {
-            return background;
+            for (int x = 0; x < image_width; x += size)
+            {
+                tiles.push_back({x, y, std::min(x + size, image_width), std::min(y + size, image_height)});
+            }
         }
 
-        color color_from_emission = rec.mat->emitted(rec.u, rec.v, rec.p);
+        int total = static_cast<int>(tiles.size());
+        int workers = thread_count > 0 ? thread_count : static_cast<int>(std::thread::hardware_concurrency());
+        workers = std::max(1, std::min(workers, total));
+
+        // tiles are claimed from a shared counter so faster threads pick up more work
+        std::atomic<int> next_tile(0);
+        std::atomic<int> tiles_done(0);
+        std::atomic<uint64_t> samples_taken(0);
+        std::mutex progress_mutex;
 
-        if (!rec.mat->scatter(r, rec, attenuation, scattered))
+        auto worker = [&]()
         {
-            return color_from_emission;
+            for (int index = next_tile++; index < total; index = next_tile++)
+            {
+                // tiles already running finish their pixels, so a budget may be overrun by a few tiles
+                if (std::chrono::steady_clock::now() >= deadline || samples_taken.load() >= budget)
+                {
+                    break;
+                }
+
+                render_stats paths;
+                paths.path_depths.assign(size_t(std::max(max_depth, 0)) + 1, 0);
+                paths.roulette_depths.assign(paths.path_depths.size(), 0);
+
+                samples_taken += render_tile(tiles[index], world, samples, cap, paths);
+
+                int done = ++tiles_done;
+                std::lock_guard<std::mutex> lock(progress_mutex);
+
+                stats.add_paths(paths);
+
+                if (show_progress)
+                {
+                    print_progress_bar(pass * total + done, passes * total);
+                }
+            }
+        };
+
+        // the calling thread works alongside the pool
+        std::vector<std::thread> pool;
+
+        for (int t = 1; t < workers; t++)
+        {
+            pool.emplace_back(worker);
+        }
+
+        worker();
+
+        for (auto &thread : pool)
+        {
+            thread.join();
         }
 
-        color color_from_scatter = attenuation * ray_color(scattered, depth - 1, world);
+        return samples_taken.load();
+    }
 
-        return color_from_emission + color_from_scatter;
+    // true once adaptive sampling considers the pixel smooth enough
+    bool pixel_converged(int i, int j) const
+    {
+        uint32_t have = accumulation.sample_count(i, j);
+
+        return adaptive.enabled && have >= uint32_t(std::max(adaptive.min_samples, 2)) &&
+               1.96 * accumulation.relative_error(size_t(j) * image_width + i) <= adaptive.tolerance;
+    }
+
+    // true once the budget is spent or no pixel would take another sample under the cap
+    bool finished(uint32_t cap, uint64_t budget) const
+    {
+        if (budget != no_budget && accumulation.total_samples() >= budget)
+        {
+            return true;
+        }
+
+        for (int j = 0; j < image_height; j++)
+        {
+            for (int i = 0; i < image_width; i++)
+            {
+                if (accumulation.sample_count(i, j) < cap && !pixel_converged(i, j))
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // add up to samples samples to every pixel of one tile that is under the cap and not converged, returns the
+    // number of samples taken
+    uint64_t render_tile(const tile &region, const hittable &world, int samples, uint32_t cap, render_stats &paths)
+    {
+        uint64_t taken = 0;
+
+        for (int j = region.y0; j < region.y1; j++)
+        {
+            for (int i = region.x0; i < region.x1; i++)
+            {
+                uint32_t have = accumulation.sample_count(i, j);
+
+                if (have >= cap || pixel_converged(i, j))
+                {
+                    continue;
+                }
+
+                int sample_count = static_cast<int>(std::min<uint32_t>(samples, cap - have));
+                color pixel_color(0, 0, 0);
+                double luminance_squares = 0;
+
+                // samples already in the buffer are skipped in the pixel's random stream
+                thread_rng().seed_pixel(seed, size_t(j) * image_width + i, have);
+
+                for (int sample = 0; sample < sample_count; sample++)
+                {
+                    try
+                    {
+                        ray r = get_ray(i, j);
+                        color sample_color = ray_color(r, world, paths);
+                        double luminance = accumulation_buffer::luminance(sample_color);
+
+                        pixel_color += sample_color;
+                        luminance_squares += luminance * luminance;
+                    }
+
+                    catch (const std::exception &e)
+                    {
+                        debugger::getInstance().logToFile(e.what());
+                    }
+                }
+
+                accumulation.add(i, j, pixel_color, sample_count, luminance_squares);
+                taken += sample_count;
+            }
+        }
+
+        return taken;
     }
 
     // function to print progress bar
     void print_progress_bar(int progress, int total, int bar_width = 100)
     {
-        double ratio = static_cast<double>(progress) / (total - 1);
+        double ratio = static_cast<double>(progress) / total;
         int filled_length = static_cast<int>(ratio * bar_width);
 
         std::cout << "\r[";
@@ -186,25 +847,6 @@ private:
         std::cout << "] " << static_cast<int>(ratio * 100) << "%";
         std::cout.flush();
     }
-
-    // write the color to the PPM file
-    void write_color(std::ostream &out, const color &pixel_color)
-    {
-        auto r = pixel_color.x();
-        auto g = pixel_color.y();
-        auto b = pixel_color.z();
-
-        r = (r > 0) ? std::sqrt(r) : 0;
-        g = (g > 0) ? std::sqrt(g) : 0;
-        b = (b > 0) ? std::sqrt(b) : 0;
-
-        static const interval intensity(0.000, 0.999);
-        int rbyte = int(256 * intensity.clamp(r));
-        int gbyte = int(256 * intensity.clamp(g));
-        int bbyte = int(256 * intensity.clamp(b));
-
-        out << rbyte << ' ' << gbyte << ' ' << bbyte << '\n';
-    }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,147 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+// header file for saving the accumulation buffer of a render to disk and picking it up again, every pixel's random
+// stream is set by the render seed, the pixel, and the samples it already has, so the buffer and the seed are all the
+// state a render needs to carry on exactly where it stopped
+
+// include
+#include "utility.h"
+#include "accumulation_buffer.h"
+#include "mapped_file.h"
+#include "bvh_cache.h"
+
+#include <filesystem>
+
+// render_checkpoint
+class render_checkpoint
+{
+public:
+    // bump when the file layout changes
+    static const uint32_t version = 1;
+
+    // write the buffer to a temporary file and move it into place, so a crash mid write keeps the last checkpoint
+    static bool save(const std::string &filename, const accumulation_buffer &buffer, uint64_t seed, uint64_t fingerprint)
+    {
+        size_t pixels = buffer.samples.size();
+        std::vector<unsigned char> payload(pixels * (3 * sizeof(float) + sizeof(uint32_t) + sizeof(float)));
+
+        unsigned char *p = payload.data();
+        std::memcpy(p, buffer.sum.data(), pixels * 3 * sizeof(float));
+        p += pixels * 3 * sizeof(float);
+        std::memcpy(p, buffer.samples.data(), pixels * sizeof(uint32_t));
+        p += pixels * sizeof(uint32_t);
+        std::memcpy(p, buffer.luminance_squares.data(), pixels * sizeof(float));
+
+        header h;
+        std::memcpy(h.magic, "RTCKPT01", 8);
+        h.version = version;
+        h.width = static_cast<uint32_t>(buffer.width);
+        h.height = static_cast<uint32_t>(buffer.height);
+        h.seed = seed;
+        h.fingerprint = fingerprint;
+        h.checksum = hash_bytes(payload.data(), payload.size());
+
+        std::error_code error;
+        std::filesystem::path parent = std::filesystem::path(filename).parent_path();
+
+        if (!parent.empty())
+        {
+            std::filesystem::create_directories(parent, error);
+        }
+
+        std::string temp_filename = cache_temp_name(filename);
+
+        {
+            std::ofstream out(temp_filename, std::ios::binary | std::ios::trunc);
+
+            if (!out)
+            {
+                debugger::getInstance().logToFile("Could not write checkpoint " + temp_filename);
+                return false;
+            }
+
+            out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+            out.write(reinterpret_cast<const char *>(payload.data()), payload.size());
+
+            if (!out)
+            {
+                out.close();
+                std::filesystem::remove(temp_filename, error);
+                return false;
+            }
+        }
+
+        std::filesystem::rename(temp_filename, filename, error);
+
+        if (error)
+        {
+            std::filesystem::remove(temp_filename, error);
+            return false;
+        }
+
+        return true;
+    }
+
+    // read the buffer back, only if the file is whole and was written for the same seed and scene fingerprint
+    static bool load(const std::string &filename, accumulation_buffer &buffer, uint64_t seed, uint64_t fingerprint)
+    {
+        mapped_file file(filename);
+
+        if (!file.is_open() || file.size() < sizeof(header))
+        {
+            return false;
+        }
+
+        header h;
+        std::memcpy(&h, file.data(), sizeof(h));
+
+        size_t pixels = size_t(h.width) * h.height;
+        size_t payload_size = pixels * (3 * sizeof(float) + sizeof(uint32_t) + sizeof(float));
+
+        if (std::memcmp(h.magic, "RTCKPT01", 8) != 0 || h.version != version || file.size() != sizeof(header) + payload_size)
+        {
+            debugger::getInstance().logToFile("Checkpoint " + filename + " is not a checkpoint of this version");
+            return false;
+        }
+
+        if (h.seed != seed || h.fingerprint != fingerprint)
+        {
+            debugger::getInstance().logToFile("Checkpoint " + filename + " belongs to another scene, camera, or seed");
+            return false;
+        }
+
+        const unsigned char *p = file.data() + sizeof(header);
+
+        if (hash_bytes(p, payload_size) != h.checksum)
+        {
+            debugger::getInstance().logToFile("Checkpoint " + filename + " is damaged");
+            return false;
+        }
+
+        buffer.reset(static_cast<int>(h.width), static_cast<int>(h.height));
+        std::memcpy(buffer.sum.data(), p, pixels * 3 * sizeof(float));
+        p += pixels * 3 * sizeof(float);
+        std::memcpy(buffer.samples.data(), p, pixels * sizeof(uint32_t));
+        p += pixels * sizeof(uint32_t);
+        std::memcpy(buffer.luminance_squares.data(), p, pixels * sizeof(float));
+
+        return true;
+    }
+
+private:
+    // file header, followed by the sums, the sample counts, and the squared luminance sums
+    struct header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        uint32_t reserved = 0;
+        uint64_t seed;
+        uint64_t fingerprint;
+        uint64_t checksum;
+    };
+};
+
+#endif
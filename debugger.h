@@ -1,15 +1,26 @@
 #ifndef DEBUGGER_H
 #define DEBUGGER_H
 
-// header file for raytrace debugger
+// header file for raytrace debugger, messages are copied into a fixed ring of records without locking and a
+// background thread writes them to their files in batches, so logging never waits on the disk
 
 // include
 #include "utility.h"
 
+#include <condition_variable>
+#include <map>
+
 // debugger
 class debugger
 {
 public:
+    // records the ring holds, a full ring drops new messages instead of waiting (must be a power of two)
+    static const size_t capacity = 4096;
+
+    // longest message and file name kept, longer ones are cut
+    static const size_t max_message = 440;
+    static const size_t max_filename = 61;
+
     // get instance of debugger to be able to call from any class
     static debugger &getInstance()
     {
@@ -21,19 +32,207 @@ public:
     // log to debugger file
     void logToFile(const std::string &message, const std::string &filename = "debug.log")
     {
-        std::ofstream file(filename, std::ios::app);
+        size_t position = enqueue_position.load(std::memory_order_relaxed);
+        cell *slot;
+
+        // claim a free cell, give up if the writer has not caught up
+        while (true)
+        {
+            slot = &cells[position & (capacity - 1)];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t difference = intptr_t(sequence) - intptr_t(position);
+
+            if (difference == 0)
+            {
+                if (enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+
+            else if (difference < 0)
+            {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            else
+            {
+                position = enqueue_position.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->message_length = static_cast<uint16_t>(std::min(message.size(), max_message));
+        slot->filename_length = static_cast<uint8_t>(std::min(filename.size(), max_filename));
+        std::memcpy(slot->message, message.data(), slot->message_length);
+        std::memcpy(slot->filename, filename.data(), slot->filename_length);
+
+        slot->sequence.store(position + 1, std::memory_order_release);
+    }
+
+    // wait until every message logged so far is in its file
+    void flush()
+    {
+        size_t target = enqueue_position.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(writer_mutex);
+
+        flush_requested = true;
+        writer_wake.notify_one();
+        written.wait(lock, [&]()
+                     { return written_position >= target; });
+    }
+
+    // messages lost because the ring was full
+    size_t dropped_count() const
+    {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+    debugger(const debugger &) = delete;
+    debugger &operator=(const debugger &) = delete;
+
+    // write everything that is left before the program ends
+    ~debugger()
+    {
+        {
+            std::lock_guard<std::mutex> lock(writer_mutex);
+            stopping = true;
+        }
+
+        writer_wake.notify_one();
+        writer.join();
+    }
+
+private:
+    // one fixed size record
+    struct cell
+    {
+        std::atomic<size_t> sequence;
+        uint16_t message_length;
+        uint8_t filename_length;
+        char filename[max_filename];
+        char message[max_message];
+    };
+
+    std::unique_ptr<cell[]> cells;
+    alignas(64) std::atomic<size_t> enqueue_position{0};
+    alignas(64) std::atomic<size_t> dropped{0};
+
+    // only touched by the writer thread
+    size_t dequeue_position = 0;
+    size_t dropped_reported = 0;
+    std::map<std::string, std::ofstream> files;
+
+    // writer thread and its wake up
+    std::mutex writer_mutex;
+    std::condition_variable writer_wake, written;
+    size_t written_position = 0;
+    bool stopping = false, flush_requested = false;
+    std::thread writer;
+
+    // how long the writer sleeps when the ring is empty
+    static constexpr std::chrono::milliseconds idle_wait{10};
+
+    // start the writer
+    debugger() : cells(new cell[capacity])
+    {
+        for (size_t i = 0; i < capacity; i++)
+        {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        writer = std::thread(&debugger::write_loop, this);
+    }
 
-        if (file.is_open())
+    // drain the ring until the debugger is destroyed
+    void write_loop()
+    {
+        while (true)
         {
-            file << "[LOG]: " << message << std::endl;
-            file.close();
+            bool stop;
+
+            {
+                std::unique_lock<std::mutex> lock(writer_mutex);
+                writer_wake.wait_for(lock, idle_wait, [&]()
+                                     { return stopping || flush_requested; });
+                stop = stopping;
+                flush_requested = false;
+            }
+
+            write_batch();
+
+            if (stop)
+            {
+                // anything logged while stopping is written too
+                write_batch();
+                files.clear();
+                return;
+            }
         }
+    }
 
-        else
+    // write every record that is ready, grouped by file, then report drops and wake flush()
+    void write_batch()
+    {
+        std::map<std::string, std::string> batch;
+        std::string filename;
+
+        while (true)
         {
-            std::cerr << "[ERROR]: Could not open file: " << filename << std::endl;
+            cell &slot = cells[dequeue_position & (capacity - 1)];
+
+            if (slot.sequence.load(std::memory_order_acquire) != dequeue_position + 1)
+            {
+                break;
+            }
+
+            filename.assign(slot.filename, slot.filename_length);
+            std::string &text = batch[filename];
+            text += "[LOG]: ";
+            text.append(slot.message, slot.message_length);
+            text += '\n';
+
+            slot.sequence.store(dequeue_position + capacity, std::memory_order_release);
+            dequeue_position++;
+        }
+
+        size_t dropped_now = dropped.load(std::memory_order_relaxed);
+
+        if (dropped_now != dropped_reported)
+        {
+            batch["debug.log"] += "[LOG]: " + std::to_string(dropped_now - dropped_reported) + " messages dropped, the log could not keep up\n";
+            dropped_reported = dropped_now;
         }
+
+        for (auto &entry : batch)
+        {
+            std::ofstream &file = files[entry.first];
+
+            if (!file.is_open())
+            {
+                file.open(entry.first, std::ios::app);
+            }
+
+            if (file.is_open())
+            {
+                file.write(entry.second.data(), entry.second.size());
+                file.flush();
+            }
+
+            else
+            {
+                std::cerr << "[ERROR]: Could not open file: " << entry.first << std::endl;
+                files.erase(entry.first);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(writer_mutex);
+            written_position = dequeue_position;
+        }
+
+        written.notify_all();
     }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -10,6 +10,12 @@
 // material
 class material;
 
+// hash of a material, defined with the materials
+inline uint64_t material_fingerprint(const material *mat);
+
+// hittable
+class hittable;
+
 // place_hit
 class place_hit
 {
@@ -18,22 +24,91 @@ public:
   bool front_face;
   point3 p;
   vec3 normal;
-  shared_ptr<material> mat;
+
+  // material of the hit, owned by the object that was hit (a plain pointer so copying a record costs no atomic
+  // reference counting)
+  const material *mat = nullptr;
+
+  // object that recorded the hit and fills in the rest of the record once it is known to be the closest, and the
+  // primitive inside it (until then u and v may hold the object's own coordinates of the hit)
+  const hittable *object = nullptr;
+  uint32_t primitive = 0;
+
+  // object an instance recorded the hit for, finished in the instance's space once the instance is the closest
+  const hittable *instanced = nullptr;
 
   void set_face_normal(const ray &r, const vec3 &outward_normal)
   {
     front_face = dot(r.direction(), outward_normal) < 0;
     normal = front_face ? outward_normal : -outward_normal;
   }
+
+  // fill in the point, normal, uv, and material of the closest hit found along r
+  void finish(const ray &r);
 };
 
 // hittable
 class hittable
 {
 public:
+  // find the closest hit in ray_t, recording only t, the object, and what the object's set_hit needs to finish it
+  // (candidates that a closer hit replaces never pay for points, normals, or uvs)
+  // every hit must set rec.object, to the object whose set_hit finishes it, or to nullptr when the whole record was
+  // filled in right away, otherwise the object of a farther candidate is left behind and finishes the closer hit
   virtual bool intersect(const ray &r, interval ray_t, place_hit &rec) const = 0;
 
+  // fill in the point, normal, uv, and material of a hit this object recorded along r (the default keeps the record as
+  // intersect filled it in, for objects that record their hits whole and set rec.object to themselves)
+  virtual void set_hit(const ray &, place_hit &) const {}
+
   virtual AA_bounding_box bounding_box() const = 0;
+
+  // pdf over the solid angle seen from origin of random(origin, time) giving direction, with the object where it is
+  // at the given time (0 for objects that are not sampled)
+  virtual double pdf_value(const point3 &, const vec3 &, double) const
+  {
+    return 0.0;
+  }
+
+  // random direction from origin toward a point of the object at the given time
+  virtual vec3 random(const point3 &, double) const
+  {
+    return vec3(1, 0, 0);
+  }
+
+  // hash of the object's geometry and material, used to check that a saved render belongs to the same scene
+  // (objects that do not know better hash their bounding box)
+  virtual uint64_t fingerprint() const
+  {
+    return box_fingerprint();
+  }
+
+  // hash of the bounding box
+  uint64_t box_fingerprint() const
+  {
+    AA_bounding_box box = bounding_box();
+    uint64_t hash = 0;
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+      hash = hash_double(hash, box.axis_interval(axis).min);
+      hash = hash_double(hash, box.axis_interval(axis).max);
+    }
+
+    return hash;
+  }
 };
 
+// let the object that recorded the hit fill in the rest of the record (only once, a record filled in right away has
+// no object left to call)
+inline void place_hit::finish(const ray &r)
+{
+  if (object != nullptr)
+  {
+    const hittable *recorded = object;
+    object = nullptr;
+    recorded->set_hit(r, *this);
+  }
+}
+
 #endif
\ No newline at end of file
@@ -74,6 +74,19 @@ public:
         return true;
     }
 
+    // hash of the size and pixels of the image
+    uint64_t fingerprint() const
+    {
+        uint64_t hash = hash_combine(uint64_t(width()), uint64_t(height()));
+
+        if (bdata == nullptr)
+        {
+            return hash;
+        }
+
+        return hash_combine(hash, hash_bytes(bdata, size_t(image_height) * bytes_per_scanline));
+    }
+
     // get the pixel data of the x,y coordinate of the image
     const unsigned char *pixel_data(int x, int y) const
     {
@@ -0,0 +1,313 @@
+#ifndef IMAGE_WRITER_H
+#define IMAGE_WRITER_H
+
+// header file for a linear float image and for writing it out as a binary ppm, a png (both through the tonemap pass),
+// or a half float openexr file, each file is encoded in memory and written with one call
+
+// define
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+
+// include
+#include "utility.h"
+#include "tonemap.h"
+
+// the implementation is compiled here, in the one translation unit, with the vendored file's own warnings kept quiet
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+#endif
+
+#include "stb_image_write.h"
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+// linear rgb framebuffer, three floats per pixel in scanline order
+struct framebuffer
+{
+    int width = 0, height = 0;
+    std::vector<float> rgb;
+
+    // constructors
+    framebuffer() {}
+    framebuffer(int width, int height) : width(width), height(height), rgb(size_t(width) * height * 3, 0.0f) {}
+
+    // set one pixel
+    void set(int i, int j, const color &pixel_color)
+    {
+        float *pixel = &rgb[(size_t(j) * width + i) * 3];
+
+        pixel[0] = static_cast<float>(pixel_color.x());
+        pixel[1] = static_cast<float>(pixel_color.y());
+        pixel[2] = static_cast<float>(pixel_color.z());
+    }
+};
+
+// file formats the writer knows
+enum class image_format
+{
+    // binary 8 bit P6
+    ppm,
+    // 8 bit rgb png
+    png,
+    // linear half float rgb openexr
+    exr
+};
+
+// image_writer
+class image_writer
+{
+public:
+    // pick the format from the file extension, anything unknown is written as a ppm
+    static image_format format_for(const std::string &filename)
+    {
+        std::string extension = filename.substr(std::min(filename.size(), filename.find_last_of('.')));
+
+        for (char &c : extension)
+        {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+
+        if (extension == ".png")
+        {
+            return image_format::png;
+        }
+
+        if (extension == ".exr")
+        {
+            return image_format::exr;
+        }
+
+        return image_format::ppm;
+    }
+
+    // encode the image in the format of the file extension and write it, the tonemap only applies to 8 bit formats
+    static bool write(const std::string &filepath, const framebuffer &image, const tonemap_settings &tonemap = tonemap_settings())
+    {
+        std::vector<unsigned char> bytes;
+
+        switch (format_for(filepath))
+        {
+        case image_format::png:
+            bytes = encode_png(image, tonemap);
+            break;
+        case image_format::exr:
+            bytes = encode_exr(image);
+            break;
+        default:
+            bytes = encode_ppm(image, tonemap);
+            break;
+        }
+
+        std::ofstream out(filepath, std::ios::binary | std::ios::trunc);
+
+        if (!out)
+        {
+            return false;
+        }
+
+        out.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+
+        return static_cast<bool>(out);
+    }
+
+    // binary P6
+    static std::vector<unsigned char> encode_ppm(const framebuffer &image, const tonemap_settings &tonemap = tonemap_settings())
+    {
+        std::string header = "P6\n" + std::to_string(image.width) + ' ' + std::to_string(image.height) + "\n255\n";
+        std::vector<unsigned char> bytes(header.begin(), header.end());
+
+        bytes.resize(header.size() + image.rgb.size());
+        tonemap_to_bytes(image.rgb.data(), bytes.data() + header.size(), image.rgb.size(), tonemap);
+
+        return bytes;
+    }
+
+    // 8 bit rgb png through stb_image_write
+    static std::vector<unsigned char> encode_png(const framebuffer &image, const tonemap_settings &tonemap = tonemap_settings())
+    {
+        std::vector<unsigned char> pixels(image.rgb.size());
+        tonemap_to_bytes(image.rgb.data(), pixels.data(), image.rgb.size(), tonemap);
+
+        std::vector<unsigned char> bytes;
+        stbi_write_png_to_func(append_bytes, &bytes, image.width, image.height, 3, pixels.data(), image.width * 3);
+
+        return bytes;
+    }
+
+    // single part scanline openexr, uncompressed half float r, g, b in linear light
+    static std::vector<unsigned char> encode_exr(const framebuffer &image)
+    {
+        std::vector<unsigned char> bytes = {0x76, 0x2f, 0x31, 0x01};
+        put_u32_le(bytes, 2);
+
+        // channels are listed in alphabetical order
+        std::vector<unsigned char> channels;
+
+        for (const char *name : {"B", "G", "R"})
+        {
+            channels.push_back(static_cast<unsigned char>(name[0]));
+            channels.push_back(0);
+            put_u32_le(channels, 1);
+            channels.insert(channels.end(), {0, 0, 0, 0});
+            put_u32_le(channels, 1);
+            put_u32_le(channels, 1);
+        }
+
+        channels.push_back(0);
+
+        std::vector<unsigned char> window;
+        put_u32_le(window, 0);
+        put_u32_le(window, 0);
+        put_u32_le(window, image.width - 1);
+        put_u32_le(window, image.height - 1);
+
+        std::vector<unsigned char> one;
+        put_f32_le(one, 1.0f);
+
+        std::vector<unsigned char> center;
+        put_f32_le(center, 0.0f);
+        put_f32_le(center, 0.0f);
+
+        put_exr_attribute(bytes, "channels", "chlist", channels);
+        put_exr_attribute(bytes, "compression", "compression", {0});
+        put_exr_attribute(bytes, "dataWindow", "box2i", window);
+        put_exr_attribute(bytes, "displayWindow", "box2i", window);
+        put_exr_attribute(bytes, "lineOrder", "lineOrder", {0});
+        put_exr_attribute(bytes, "pixelAspectRatio", "float", one);
+        put_exr_attribute(bytes, "screenWindowCenter", "v2f", center);
+        put_exr_attribute(bytes, "screenWindowWidth", "float", one);
+        bytes.push_back(0);
+
+        // offset table, one scanline per block
+        size_t line_bytes = size_t(image.width) * 3 * 2;
+        size_t first_line = bytes.size() + size_t(image.height) * 8;
+
+        for (int y = 0; y < image.height; y++)
+        {
+            put_u64_le(bytes, first_line + size_t(y) * (8 + line_bytes));
+        }
+
+        bytes.reserve(first_line + size_t(image.height) * (8 + line_bytes));
+
+        for (int y = 0; y < image.height; y++)
+        {
+            put_u32_le(bytes, y);
+            put_u32_le(bytes, static_cast<uint32_t>(line_bytes));
+
+            for (int channel = 2; channel >= 0; channel--)
+            {
+                for (int x = 0; x < image.width; x++)
+                {
+                    uint16_t half = to_half(image.rgb[(size_t(y) * image.width + x) * 3 + channel]);
+
+                    bytes.push_back(static_cast<unsigned char>(half & 0xff));
+                    bytes.push_back(static_cast<unsigned char>(half >> 8));
+                }
+            }
+        }
+
+        return bytes;
+    }
+
+    // float to ieee half, rounded to nearest even
+    static uint16_t to_half(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        uint32_t sign = (bits >> 16) & 0x8000;
+        uint32_t magnitude = bits & 0x7fffffff;
+
+        // nan and infinity
+        if (magnitude >= 0x7f800000)
+        {
+            return static_cast<uint16_t>(sign | 0x7c00 | (magnitude > 0x7f800000 ? 0x200 : 0));
+        }
+
+        // too big for a half
+        if (magnitude >= 0x477ff000)
+        {
+            return static_cast<uint16_t>(sign | 0x7c00);
+        }
+
+        // subnormal halves (and zero)
+        if (magnitude < 0x38800000)
+        {
+            if (magnitude < 0x33000000)
+            {
+                return static_cast<uint16_t>(sign);
+            }
+
+            uint32_t exponent = magnitude >> 23;
+            uint32_t mantissa = (magnitude & 0x7fffff) | 0x800000;
+            uint32_t shift = 126 - exponent;
+            uint32_t half = mantissa >> shift;
+            uint32_t rest = mantissa & ((1u << shift) - 1);
+            uint32_t halfway = 1u << (shift - 1);
+
+            if (rest > halfway || (rest == halfway && (half & 1)))
+            {
+                half++;
+            }
+
+            return static_cast<uint16_t>(sign | half);
+        }
+
+        uint32_t half = ((magnitude - 0x38000000) >> 13);
+        uint32_t rest = magnitude & 0x1fff;
+
+        if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+        {
+            half++;
+        }
+
+        return static_cast<uint16_t>(sign | half);
+    }
+
+private:
+    // little endian helpers
+    static void put_u32_le(std::vector<unsigned char> &out, uint32_t value)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            out.push_back(static_cast<unsigned char>(value >> (8 * i)));
+        }
+    }
+
+    static void put_u64_le(std::vector<unsigned char> &out, uint64_t value)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            out.push_back(static_cast<unsigned char>(value >> (8 * i)));
+        }
+    }
+
+    static void put_f32_le(std::vector<unsigned char> &out, float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        put_u32_le(out, bits);
+    }
+
+    // exr header attribute: name, type, size, value
+    static void put_exr_attribute(std::vector<unsigned char> &out, const char *name, const char *type, const std::vector<unsigned char> &value)
+    {
+        out.insert(out.end(), name, name + std::strlen(name) + 1);
+        out.insert(out.end(), type, type + std::strlen(type) + 1);
+        put_u32_le(out, static_cast<uint32_t>(value.size()));
+        out.insert(out.end(), value.begin(), value.end());
+    }
+
+    // stb_image_write callback, appends to the byte vector it is handed
+    static void append_bytes(void *context, void *data, int size)
+    {
+        std::vector<unsigned char> *out = static_cast<std::vector<unsigned char> *>(context);
+        const unsigned char *bytes = static_cast<const unsigned char *>(data);
+
+        out->insert(out->end(), bytes, bytes + size);
+    }
+};
+
+#endif
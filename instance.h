@@ -0,0 +1,253 @@
+#ifndef INSTANCE_H
+#define INSTANCE_H
+
+// header file for placing shared geometry in the world more than once, each placement moving the ray into the
+// geometry's own space with an affine transform instead of copying the geometry
+
+// include
+#include "utility.h"
+
+// affine_transform, a 3x3 linear part m and a translation t (p' = m * p + t)
+class affine_transform
+{
+public:
+    double m[3][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+    vec3 t;
+
+    // identity
+    affine_transform() {}
+
+    // move by offset
+    static affine_transform translate(const vec3 &offset)
+    {
+        affine_transform result;
+        result.t = offset;
+
+        return result;
+    }
+
+    // scale along each axis
+    static affine_transform scale(const vec3 &factor)
+    {
+        affine_transform result;
+
+        for (int i = 0; i < 3; i++)
+        {
+            result.m[i][i] = factor[i];
+        }
+
+        return result;
+    }
+
+    // scale the same on every axis
+    static affine_transform scale(double factor)
+    {
+        return scale(vec3(factor, factor, factor));
+    }
+
+    // rotate around an axis through the origin by an angle in degrees
+    static affine_transform rotate(const vec3 &axis, double degrees)
+    {
+        vec3 a = unit_vector(axis);
+        double radians = degrees_to_radians(degrees);
+        double c = std::cos(radians), s = std::sin(radians), k = 1 - c;
+
+        affine_transform result;
+        result.m[0][0] = c + a.x() * a.x() * k;
+        result.m[0][1] = a.x() * a.y() * k - a.z() * s;
+        result.m[0][2] = a.x() * a.z() * k + a.y() * s;
+        result.m[1][0] = a.y() * a.x() * k + a.z() * s;
+        result.m[1][1] = c + a.y() * a.y() * k;
+        result.m[1][2] = a.y() * a.z() * k - a.x() * s;
+        result.m[2][0] = a.z() * a.x() * k - a.y() * s;
+        result.m[2][1] = a.z() * a.y() * k + a.x() * s;
+        result.m[2][2] = c + a.z() * a.z() * k;
+
+        return result;
+    }
+
+    // transform a point
+    point3 apply_point(const point3 &p) const
+    {
+        return apply_vector(p) + t;
+    }
+
+    // transform a direction (no translation)
+    vec3 apply_vector(const vec3 &v) const
+    {
+        return vec3(m[0][0] * v.x() + m[0][1] * v.y() + m[0][2] * v.z(),
+                    m[1][0] * v.x() + m[1][1] * v.y() + m[1][2] * v.z(),
+                    m[2][0] * v.x() + m[2][1] * v.y() + m[2][2] * v.z());
+    }
+
+    // transform a direction by the transpose of the linear part (used to carry normals with the inverse)
+    vec3 apply_transposed(const vec3 &v) const
+    {
+        return vec3(m[0][0] * v.x() + m[1][0] * v.y() + m[2][0] * v.z(),
+                    m[0][1] * v.x() + m[1][1] * v.y() + m[2][1] * v.z(),
+                    m[0][2] * v.x() + m[1][2] * v.y() + m[2][2] * v.z());
+    }
+
+    // the transform that undoes this one (the linear part must not be singular)
+    affine_transform inverse() const
+    {
+        affine_transform result;
+
+        double det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+                     m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+                     m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+
+        if (std::fabs(det) < 1e-300)
+        {
+            debugger::getInstance().logToFile("affine_transform has no inverse, using identity");
+            return result;
+        }
+
+        double inv_det = 1 / det;
+
+        result.m[0][0] = (m[1][1] * m[2][2] - m[1][2] * m[2][1]) * inv_det;
+        result.m[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * inv_det;
+        result.m[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * inv_det;
+        result.m[1][0] = (m[1][2] * m[2][0] - m[1][0] * m[2][2]) * inv_det;
+        result.m[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * inv_det;
+        result.m[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * inv_det;
+        result.m[2][0] = (m[1][0] * m[2][1] - m[1][1] * m[2][0]) * inv_det;
+        result.m[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * inv_det;
+        result.m[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * inv_det;
+        result.t = -result.apply_vector(t);
+
+        return result;
+    }
+};
+
+// apply b first, then a
+inline affine_transform operator*(const affine_transform &a, const affine_transform &b)
+{
+    affine_transform result;
+
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            result.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j];
+        }
+    }
+
+    result.t = a.apply_point(b.t);
+
+    return result;
+}
+
+// instance
+class instance : public hittable
+{
+public:
+    // place geometry (usually a world holding one mesh, with its own hierarchy) with the given object to world transform
+    instance(shared_ptr<hittable> geometry, const affine_transform &object_to_world)
+        : geometry(geometry), object_to_world(object_to_world), world_to_object(object_to_world.inverse())
+    {
+        set_bounding_box();
+    }
+
+    // move the ray into object space, intersect there, and bring the hit back
+    bool intersect(const ray &r, interval ray_t, place_hit &rec) const override
+    {
+        // the direction is not normalized, so t means the same distance along the ray in both spaces
+        ray object_ray(world_to_object.apply_point(r.origin()), world_to_object.apply_vector(r.direction()), r.time());
+
+        // an instance inside the geometry leaves its slot set, so a record that comes back with it set may have been
+        // recorded by a nested instance
+        const hittable *saved_instanced = rec.instanced;
+        rec.instanced = nullptr;
+
+        if (!geometry->intersect(object_ray, ray_t, rec))
+        {
+            rec.instanced = saved_instanced;
+            return false;
+        }
+
+        // nested instances have only the one slot, so their hit is finished and carried out right away
+        if (rec.instanced != nullptr)
+        {
+            rec.finish(object_ray);
+            to_world(rec);
+
+            return true;
+        }
+
+        // otherwise the hit waits, like any other, until the instance is known to be the closest
+        rec.instanced = rec.object;
+        rec.object = this;
+
+        return true;
+    }
+
+    // finish the hit of the shared geometry in object space and bring it back
+    void set_hit(const ray &r, place_hit &rec) const override
+    {
+        ray object_ray(world_to_object.apply_point(r.origin()), world_to_object.apply_vector(r.direction()), r.time());
+
+        rec.object = rec.instanced;
+        rec.finish(object_ray);
+        to_world(rec);
+    }
+
+    // get the bounding box
+    AA_bounding_box bounding_box() const override
+    {
+        return aa_bound_box;
+    }
+
+    // hash of the shared geometry and the transform
+    uint64_t fingerprint() const override
+    {
+        uint64_t hash = geometry->fingerprint();
+
+        for (int i = 0; i < 3; i++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                hash = hash_double(hash, object_to_world.m[i][j]);
+            }
+
+            hash = hash_double(hash, object_to_world.t[i]);
+        }
+
+        return hash;
+    }
+
+    // geometry shared by every placement
+    const shared_ptr<hittable> &shared_geometry() const
+    {
+        return geometry;
+    }
+
+private:
+    shared_ptr<hittable> geometry;
+    affine_transform object_to_world, world_to_object;
+    AA_bounding_box aa_bound_box;
+
+    // move a finished object space hit into the world, normals go back with the inverse transpose, which keeps their
+    // side relative to the ray
+    void to_world(place_hit &rec) const
+    {
+        rec.p = object_to_world.apply_point(rec.p);
+        rec.normal = unit_vector(world_to_object.apply_transposed(rec.normal));
+    }
+
+    // box around the eight transformed corners of the geometry box
+    void set_bounding_box()
+    {
+        AA_bounding_box box = geometry->bounding_box();
+
+        for (int corner = 0; corner < 8; corner++)
+        {
+            point3 p((corner & 1) ? box.x.max : box.x.min, (corner & 2) ? box.y.max : box.y.min, (corner & 4) ? box.z.max : box.z.min);
+            p = object_to_world.apply_point(p);
+
+            aa_bound_box = corner == 0 ? AA_bounding_box(p, p) : AA_bounding_box(aa_bound_box, AA_bounding_box(p, p));
+        }
+    }
+};
+
+#endif
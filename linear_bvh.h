@@ -0,0 +1,334 @@
+#ifndef LINEAR_BVH_H
+#define LINEAR_BVH_H
+
+// header file for the flattened bounding volume hierarchy, stored as one array of nodes in depth-first order
+
+// include
+#include "utility.h"
+#include "AA_bounding_box.h"
+#include "bvh_build.h"
+
+// 32 byte node, the left child of an interior node is always the next node in the array
+struct linear_bvh_node
+{
+    // bounds rounded outward to float so they never shrink
+    float bounds_min[3];
+    float bounds_max[3];
+
+    // leaf: first entry in primitive_indices, interior: index of the right child
+    uint32_t offset;
+
+    // number of primitives in a leaf, 0 for interior nodes
+    uint16_t count;
+
+    // axis the children were split along
+    uint8_t axis;
+    uint8_t pad;
+};
+
+static_assert(sizeof(linear_bvh_node) == 32, "linear_bvh_node must stay 32 bytes");
+
+// linear_bvh
+class linear_bvh
+{
+public:
+    // nodes in depth-first order, nodes[0] is the root
+    std::vector<linear_bvh_node> nodes;
+
+    // primitive of each leaf slot, leaves reference a contiguous range of it
+    std::vector<uint32_t> primitive_indices;
+
+    // numbers from the last build
+    bvh_build_stats stats;
+
+    // deepest the traversal stack can go
+    static const int max_depth = 128;
+
+    // constructor for an empty hierarchy
+    linear_bvh() {}
+
+    // constructor to build over the given builder references
+    linear_bvh(std::vector<bvh_primitive> refs, const bvh_build_settings &settings)
+    {
+        build(refs, settings);
+    }
+
+    // build the hierarchy over the given references (reorders them)
+    void build(std::vector<bvh_primitive> &refs, const bvh_build_settings &settings)
+    {
+        auto build_start = std::chrono::steady_clock::now();
+
+        nodes.clear();
+        primitive_indices.assign(refs.size(), 0);
+        stats = bvh_build_stats();
+
+        if (!refs.empty())
+        {
+            bvh_thread_budget budget(bvh_build_threads(settings));
+            build_node(nodes, refs, 0, refs.size(), settings, budget, 0);
+        }
+
+        update_stats(settings);
+        stats.build_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - build_start).count();
+    }
+
+    // replace the hierarchy with already built nodes and leaf slots (used when loading from disk)
+    void assign(const linear_bvh_node *node_data, size_t node_count, const uint32_t *index_data, size_t index_count, const bvh_build_settings &settings)
+    {
+        nodes.assign(node_data, node_data + node_count);
+        primitive_indices.assign(index_data, index_data + index_count);
+        stats = bvh_build_stats();
+        update_stats(settings);
+    }
+
+    // bounds of the whole hierarchy
+    AA_bounding_box bounding_box() const
+    {
+        if (nodes.empty())
+        {
+            return AA_bounding_box::empty;
+        }
+
+        return node_box(nodes[0]);
+    }
+
+    // walk the hierarchy, near child first, calling intersect_primitive(primitive, ray_t) for every primitive in a
+    // leaf the ray reaches. intersect_primitive returns true on a hit and shrinks ray_t.max to the hit distance
+    template <typename Intersect>
+    bool traverse(const ray &r, interval ray_t, Intersect &&intersect_primitive) const
+    {
+        if (nodes.empty())
+        {
+            return false;
+        }
+
+        const point3 &origin = r.origin();
+        const vec3 &direction = r.direction();
+
+        double inv_dir[3] = {1.0 / direction[0], 1.0 / direction[1], 1.0 / direction[2]};
+        bool dir_is_neg[3] = {inv_dir[0] < 0, inv_dir[1] < 0, inv_dir[2] < 0};
+
+        uint32_t stack[max_depth];
+        int stack_size = 0;
+        uint32_t current = 0;
+        bool is_hit = false;
+
+        while (true)
+        {
+            const linear_bvh_node &node = nodes[current];
+
+            if (hit_node(node, origin, inv_dir, ray_t))
+            {
+                if (node.count > 0)
+                {
+                    for (uint32_t i = node.offset; i < node.offset + node.count; i++)
+                    {
+                        if (intersect_primitive(primitive_indices[i], ray_t))
+                        {
+                            is_hit = true;
+                        }
+                    }
+                }
+
+                // visit the child on the side the ray comes from first, save the other one
+                else if (dir_is_neg[node.axis])
+                {
+                    stack[stack_size++] = current + 1;
+                    current = node.offset;
+                    continue;
+                }
+
+                else
+                {
+                    stack[stack_size++] = node.offset;
+                    current = current + 1;
+                    continue;
+                }
+            }
+
+            if (stack_size == 0)
+            {
+                break;
+            }
+
+            current = stack[--stack_size];
+        }
+
+        return is_hit;
+    }
+
+    // get the box of a node in double precision
+    static AA_bounding_box node_box(const linear_bvh_node &node)
+    {
+        return AA_bounding_box(interval(node.bounds_min[0], node.bounds_max[0]),
+                               interval(node.bounds_min[1], node.bounds_max[1]),
+                               interval(node.bounds_min[2], node.bounds_max[2]));
+    }
+
+private:
+    // append the subtree over the references in [start, end) to out in depth-first order
+    // subtrees built on two threads go to their own arrays and are spliced in behind their parent
+    void build_node(std::vector<linear_bvh_node> &out, std::vector<bvh_primitive> &refs, size_t start, size_t end,
+                    const bvh_build_settings &settings, bvh_thread_budget &budget, int depth)
+    {
+        uint32_t index = static_cast<uint32_t>(out.size());
+        out.emplace_back();
+
+        bvh_split split = bvh_choose_split(refs, start, end, settings, budget);
+
+        const AA_bounding_box box = split.box;
+        set_bounds(out[index], box);
+
+        // the node count field is 16 bits wide
+        if (split.leaf && end - start > 0xffff)
+        {
+            split = {false, start + (end - start) / 2, 0, box};
+        }
+
+        // past half of the stack budget, fall back to median splits so the depth stays logarithmic
+        if (!split.leaf && depth > max_depth / 2)
+        {
+            int axis = box.longest_axis();
+            split = {false, bvh_median_partition(refs, start, end, axis), axis, box};
+        }
+
+        if (split.leaf)
+        {
+            for (size_t i = start; i < end; i++)
+            {
+                primitive_indices[i] = static_cast<uint32_t>(refs[i].index);
+            }
+
+            out[index].offset = static_cast<uint32_t>(start);
+            out[index].count = static_cast<uint16_t>(end - start);
+            out[index].axis = 0;
+
+            return;
+        }
+
+        uint32_t right;
+
+        // large node and a spare thread: the left subtree goes to another thread, both land in their own arrays
+        if (end - start >= settings.parallel_min_objects && budget.try_acquire())
+        {
+            std::vector<linear_bvh_node> left_nodes, right_nodes;
+
+            auto build_left = [&]()
+            {
+                build_node(left_nodes, refs, start, split.mid, settings, budget, depth + 1);
+            };
+
+            std::thread worker(build_left);
+            build_node(right_nodes, refs, split.mid, end, settings, budget, depth + 1);
+            worker.join();
+            budget.release();
+
+            // left subtree right behind its parent, then the right subtree
+            right = index + 1 + static_cast<uint32_t>(left_nodes.size());
+            append_nodes(out, left_nodes, index + 1);
+            append_nodes(out, right_nodes, right);
+        }
+
+        else
+        {
+            build_node(out, refs, start, split.mid, settings, budget, depth + 1);
+            right = static_cast<uint32_t>(out.size());
+            build_node(out, refs, split.mid, end, settings, budget, depth + 1);
+        }
+
+        out[index].offset = right;
+        out[index].count = 0;
+        out[index].axis = static_cast<uint8_t>(split.axis);
+    }
+
+    // copy a subtree built from index 0 to the end of out, starting at index first
+    static void append_nodes(std::vector<linear_bvh_node> &out, const std::vector<linear_bvh_node> &subtree, uint32_t first)
+    {
+        out.reserve(out.size() + subtree.size());
+
+        for (linear_bvh_node node : subtree)
+        {
+            if (node.count == 0)
+            {
+                node.offset += first;
+            }
+
+            out.push_back(node);
+        }
+    }
+
+    // count the nodes and work out the depth and expected cost of the finished tree
+    void update_stats(const bvh_build_settings &settings)
+    {
+        stats.node_count = nodes.size();
+
+        if (nodes.empty())
+        {
+            return;
+        }
+
+        // children always come after their parent, so walking backwards sees them first
+        std::vector<double> cost(nodes.size());
+        std::vector<int> height(nodes.size());
+
+        for (size_t i = nodes.size(); i-- > 0;)
+        {
+            const linear_bvh_node &node = nodes[i];
+
+            if (node.count > 0)
+            {
+                stats.leaf_count++;
+                cost[i] = settings.intersection_cost * node.count;
+                height[i] = 1;
+                continue;
+            }
+
+            size_t left = i + 1, right = node.offset;
+            cost[i] = bvh_node_cost(settings, node_box(node), node_box(nodes[left]), cost[left], node_box(nodes[right]), cost[right]);
+            height[i] = 1 + std::max(height[left], height[right]);
+        }
+
+        stats.sah_cost = cost[0];
+        stats.depth = height[0];
+    }
+
+    // store the box in the node, rounding outward
+    static void set_bounds(linear_bvh_node &node, const AA_bounding_box &box)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            const interval &ax = box.axis_interval(axis);
+            node.bounds_min[axis] = std::nextafter(static_cast<float>(ax.min), -std::numeric_limits<float>::infinity());
+            node.bounds_max[axis] = std::nextafter(static_cast<float>(ax.max), std::numeric_limits<float>::infinity());
+        }
+    }
+
+    // slab test of the ray against the node box
+    static bool hit_node(const linear_bvh_node &node, const point3 &origin, const double inv_dir[3], const interval &ray_t)
+    {
+        double t_min = ray_t.min, t_max = ray_t.max;
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            double t0 = (node.bounds_min[axis] - origin[axis]) * inv_dir[axis];
+            double t1 = (node.bounds_max[axis] - origin[axis]) * inv_dir[axis];
+
+            if (inv_dir[axis] < 0)
+            {
+                std::swap(t0, t1);
+            }
+
+            t_min = t0 > t_min ? t0 : t_min;
+            t_max = t1 < t_max ? t1 : t_max;
+
+            if (t_max < t_min)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+// header file for read-only memory mapped files
+
+// include
+#include "utility.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// mapped_file
+class mapped_file
+{
+public:
+    // constructor to map the whole file with the given name, is_open() tells if it worked
+    mapped_file(const std::string &filename)
+    {
+#if defined(_WIN32)
+        file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return;
+        }
+
+        LARGE_INTEGER file_size;
+
+        if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+        {
+            return;
+        }
+
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+        if (mapping == nullptr)
+        {
+            return;
+        }
+
+        bytes = static_cast<const unsigned char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        length = bytes ? static_cast<size_t>(file_size.QuadPart) : 0;
+#else
+        int fd = open(filename.c_str(), O_RDONLY);
+
+        if (fd < 0)
+        {
+            return;
+        }
+
+        struct stat info;
+
+        if (fstat(fd, &info) == 0 && info.st_size > 0)
+        {
+            void *view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (view != MAP_FAILED)
+            {
+                bytes = static_cast<const unsigned char *>(view);
+                length = static_cast<size_t>(info.st_size);
+            }
+        }
+
+        // the mapping stays valid after the descriptor is closed
+        close(fd);
+#endif
+    }
+
+    mapped_file(const mapped_file &) = delete;
+    mapped_file &operator=(const mapped_file &) = delete;
+
+    // unmap the file
+    ~mapped_file()
+    {
+#if defined(_WIN32)
+        if (bytes)
+        {
+            UnmapViewOfFile(bytes);
+        }
+
+        if (mapping)
+        {
+            CloseHandle(mapping);
+        }
+
+        if (file != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(file);
+        }
+#else
+        if (bytes)
+        {
+            munmap(const_cast<unsigned char *>(bytes), length);
+        }
+#endif
+    }
+
+    // helper functions
+    bool is_open() const
+    {
+        return bytes != nullptr;
+    }
+
+    const unsigned char *data() const
+    {
+        return bytes;
+    }
+
+    size_t size() const
+    {
+        return length;
+    }
+
+private:
+    const unsigned char *bytes = nullptr;
+    size_t length = 0;
+
+#if defined(_WIN32)
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+};
+
+#endif
@@ -8,10 +8,32 @@
 #include "utility.h"
 #include "texture.h"
 
+// the built in materials, used to pick materials when building a scene, and by the switch in the material functions
+// below that calls them without a virtual call
+enum class material_type
+{
+  diffuse,
+  specular,
+  dielectric,
+  emissive,
+  volume,
+  // only for building scenes: the magenta diffuse the world uses to show a material it does not know (never the type
+  // of a material object)
+  debug,
+  // only the type of a material object: any other material, called through its virtual functions (such materials are
+  // made by the caller and placed with world::add, the world cannot build them)
+  custom
+};
+
 // material
 class material
 {
 public:
+  // which built in material this is
+  const material_type type;
+
+  material() : type(material_type::custom) {}
+
   // function to determine the color that is emitted off the object material
   virtual color emitted(double u, double v, const point3 &p) const
   {
@@ -23,14 +45,32 @@ public:
   {
     return false;
   }
+
+  // pdf over solid angle of scatter picking the scattered direction, which is also the bsdf times the cosine divided
+  // by the attenuation, 0 for mirror like materials whose direction cannot be picked by a light sample
+  virtual double scattering_pdf(const ray &, const place_hit &, const ray &) const
+  {
+    return 0;
+  }
+
+  // hash of what the material does, used to check that a saved render belongs to the same scene (other materials only
+  // count by their type)
+  virtual uint64_t fingerprint() const
+  {
+    return hash_combine(0, uint64_t(type));
+  }
+
+protected:
+  // constructor for the built in materials
+  material(material_type type) : type(type) {}
 };
 
 // specular
-class specular : public material
+class specular final : public material
 {
 public:
   // constructor for specular material given a color and a "fuzz" value
-  specular(const color &solid_c, double spec_fuzz) : solid_c(solid_c)
+  specular(const color &solid_c, double spec_fuzz) : material(material_type::specular), solid_c(solid_c)
   {
     if (spec_fuzz > 1)
     {
@@ -55,20 +95,28 @@ public:
     return (dot(scattered.direction(), rec.normal) > 0);
   }
 
+  // hash of the color and the fuzz
+  uint64_t fingerprint() const override
+  {
+    uint64_t hash = hash_double(material::fingerprint(), fuzz);
+
+    return hash_double(hash_double(hash_double(hash, solid_c.x()), solid_c.y()), solid_c.z());
+  }
+
 private:
   double fuzz;
   color solid_c;
 };
 
 // diffuse
-class diffuse : public material
+class diffuse final : public material
 {
 public:
   // constructor to add a diffuse material with only a color
-  diffuse(const color &solid_c) : tex(make_shared<solid_color>(solid_c)) {}
+  diffuse(const color &solid_c) : material(material_type::diffuse), tex(make_shared<solid_color>(solid_c)) {}
 
   // constructor to create a diffuse object with the given texture
-  diffuse(shared_ptr<texture> tex) : tex(tex) {}
+  diffuse(shared_ptr<texture> tex) : material(material_type::diffuse), tex(tex) {}
 
   // scatter function
   bool scatter(const ray &r_in, const place_hit &rec, color &attenuation, ray &scattered) const override
@@ -81,21 +129,35 @@ public:
     }
 
     scattered = ray(rec.p, scatter_direction, r_in.time());
-    attenuation = tex->value(rec.u, rec.v, rec.p);
+    attenuation = texture_value(*tex, rec.u, rec.v, rec.p);
 
     return true;
   }
 
+  // cosine weighted directions above the surface
+  double scattering_pdf(const ray &, const place_hit &rec, const ray &scattered) const override
+  {
+    double cosine = dot(rec.normal, unit_vector(scattered.direction()));
+
+    return cosine < 0 ? 0 : cosine / pi;
+  }
+
+  // hash of the texture
+  uint64_t fingerprint() const override
+  {
+    return hash_combine(material::fingerprint(), tex->fingerprint());
+  }
+
 private:
   shared_ptr<texture> tex;
 };
 
 // dielectric
-class dielectric : public material
+class dielectric final : public material
 {
 public:
   // constructor for a dielectric material on an object
-  dielectric(double refraction_index) : refraction_index(refraction_index) {}
+  dielectric(double refraction_index) : material(material_type::dielectric), refraction_index(refraction_index) {}
 
   // scatter function
   bool scatter(const ray &r_in, const place_hit &rec, color &attenuation, ray &scattered) const override
@@ -131,6 +193,12 @@ public:
     return true;
   }
 
+  // hash of the refraction index
+  uint64_t fingerprint() const override
+  {
+    return hash_double(material::fingerprint(), refraction_index);
+  }
+
 private:
   double refraction_index;
 
@@ -145,16 +213,25 @@ private:
 };
 
 // emissive
-class emissive : public material
+class emissive final : public material
 {
 public:
   // constructor for light material given a color
-  emissive(const color &emit) : tex(make_shared<solid_color>(emit)) {}
+  emissive(const color &emit) : material(material_type::emissive), tex(make_shared<solid_color>(emit)) {}
+
+  // constructor for light material given a texture
+  emissive(shared_ptr<texture> tex) : material(material_type::emissive), tex(tex) {}
 
   // emitted function
   color emitted(double u, double v, const point3 &p) const override
   {
-    return tex->value(u, v, p);
+    return texture_value(*tex, u, v, p);
+  }
+
+  // hash of the texture
+  uint64_t fingerprint() const override
+  {
+    return hash_combine(material::fingerprint(), tex->fingerprint());
   }
 
 private:
@@ -162,23 +239,97 @@ private:
 };
 
 // volume material
-class volume_mat : public material
+class volume_mat final : public material
 {
 public:
   // constructor for volume material with a solid color
-  volume_mat(const color &solid_c) : tex(make_shared<solid_color>(solid_c)) {}
+  volume_mat(const color &solid_c) : material(material_type::volume), tex(make_shared<solid_color>(solid_c)) {}
+
+  // constructor for volume material with a texture
+  volume_mat(shared_ptr<texture> tex) : material(material_type::volume), tex(tex) {}
 
   // scatter function
   bool scatter(const ray &r_in, const place_hit &rec, color &attenuation, ray &scattered) const override
   {
     scattered = ray(rec.p, random_unit_vector(), r_in.time());
-    attenuation = tex->value(rec.u, rec.v, rec.p);
+    attenuation = texture_value(*tex, rec.u, rec.v, rec.p);
 
     return true;
   }
 
+  // every direction alike
+  double scattering_pdf(const ray &, const place_hit &, const ray &) const override
+  {
+    return 1 / (4 * pi);
+  }
+
+  // hash of the texture
+  uint64_t fingerprint() const override
+  {
+    return hash_combine(material::fingerprint(), tex->fingerprint());
+  }
+
 private:
   shared_ptr<texture> tex;
 };
 
+// the material functions the renderer calls, switching over the built in materials so their final functions are called
+// directly (and can be inlined), any other material goes through the virtual calls
+
+// hash of a material, 0 for none
+inline uint64_t material_fingerprint(const material *mat)
+{
+  return mat != nullptr ? mat->fingerprint() : 0;
+}
+
+// emitted color of a material
+inline color material_emitted(const material &mat, double u, double v, const point3 &p)
+{
+  switch (mat.type)
+  {
+  case material_type::emissive:
+    return static_cast<const emissive &>(mat).emissive::emitted(u, v, p);
+  case material_type::custom:
+    return mat.emitted(u, v, p);
+  default:
+    return color(0, 0, 0);
+  }
+}
+
+// scatter a ray off a material
+inline bool material_scatter(const material &mat, const ray &r_in, const place_hit &rec, color &attenuation, ray &scattered)
+{
+  switch (mat.type)
+  {
+  case material_type::diffuse:
+    return static_cast<const diffuse &>(mat).diffuse::scatter(r_in, rec, attenuation, scattered);
+  case material_type::specular:
+    return static_cast<const specular &>(mat).specular::scatter(r_in, rec, attenuation, scattered);
+  case material_type::dielectric:
+    return static_cast<const dielectric &>(mat).dielectric::scatter(r_in, rec, attenuation, scattered);
+  case material_type::volume:
+    return static_cast<const volume_mat &>(mat).volume_mat::scatter(r_in, rec, attenuation, scattered);
+  case material_type::custom:
+    return mat.scatter(r_in, rec, attenuation, scattered);
+  default:
+    return false;
+  }
+}
+
+// pdf of a material scattering toward the given ray
+inline double material_scattering_pdf(const material &mat, const ray &r_in, const place_hit &rec, const ray &scattered)
+{
+  switch (mat.type)
+  {
+  case material_type::diffuse:
+    return static_cast<const diffuse &>(mat).diffuse::scattering_pdf(r_in, rec, scattered);
+  case material_type::volume:
+    return static_cast<const volume_mat &>(mat).volume_mat::scattering_pdf(r_in, rec, scattered);
+  case material_type::custom:
+    return mat.scattering_pdf(r_in, rec, scattered);
+  default:
+    return 0;
+  }
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,163 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+// header file for the on-disk cache of parsed .obj files, keyed by a hash of the file's bytes, a hit hands back the
+// same buffers the parser would have made without reading a single line of the file
+
+// include
+#include "utility.h"
+#include "mapped_file.h"
+#include "bvh_cache.h"
+#include "triangle_mesh.h"
+
+static_assert(sizeof(vec3) == 3 * sizeof(double), "mesh cache files store vec3 as three doubles");
+
+// mesh_cache
+class mesh_cache
+{
+public:
+    // turn the cache on or off
+    bool enabled = true;
+
+    // folder the cache files are kept in
+    std::string directory = "Cache";
+
+    // smaller files parse faster than they load, so they are never cached
+    size_t min_file_bytes = size_t(4) << 20;
+
+    // bump when the file layout or the parser output changes
+    static const uint32_t version = 1;
+
+    // hash of the bytes of an .obj file
+    static uint64_t key(const unsigned char *data, size_t size)
+    {
+        return hash_combine(hash_combine(0x3c6ef372fe94f82bULL, version), hash_combine(size, hash_bytes(data, size)));
+    }
+
+    // cache file for a key
+    std::string file_for(uint64_t hash) const
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "obj-%016llx.bin", static_cast<unsigned long long>(hash));
+
+        return directory + "/" + name;
+    }
+
+    // fill mesh from the cache file for the key, refusing anything that does not match or is damaged
+    bool load(uint64_t hash, triangle_mesh_data &mesh) const
+    {
+        mapped_file file(file_for(hash));
+
+        if (!file.is_open() || file.size() < sizeof(header))
+        {
+            return false;
+        }
+
+        header h;
+        std::memcpy(&h, file.data(), sizeof(h));
+
+        if (std::memcmp(h.magic, "RTOBJC01", 8) != 0 || h.version != version || h.key != hash)
+        {
+            return false;
+        }
+
+        // every buffer's size, checked without overflowing on a damaged header
+        uint64_t payload_bytes = 0;
+
+        for (int i = 0; i < buffer_count; i++)
+        {
+            if (h.counts[i] > (uint64_t(1) << 40))
+            {
+                return false;
+            }
+
+            payload_bytes += h.counts[i] * element_size(i);
+        }
+
+        if (file.size() != sizeof(header) + payload_bytes || hash_bytes(file.data() + sizeof(header), payload_bytes) != h.checksum)
+        {
+            return false;
+        }
+
+        mesh = triangle_mesh_data();
+        const unsigned char *at = file.data() + sizeof(header);
+
+        read(at, h.counts[0], mesh.vertices);
+        read(at, h.counts[1], mesh.normals);
+        read(at, h.counts[2], mesh.uvs);
+        read(at, h.counts[3], mesh.indices);
+        read(at, h.counts[4], mesh.normal_indices);
+        read(at, h.counts[5], mesh.uv_indices);
+
+        return true;
+    }
+
+    // write the buffers of a parsed file to its cache file
+    void save(uint64_t hash, const triangle_mesh_data &mesh) const
+    {
+        header h;
+        std::memcpy(h.magic, "RTOBJC01", 8);
+        h.version = version;
+        h.reserved = 0;
+        h.key = hash;
+        h.counts[0] = mesh.vertices.size();
+        h.counts[1] = mesh.normals.size();
+        h.counts[2] = mesh.uvs.size();
+        h.counts[3] = mesh.indices.size();
+        h.counts[4] = mesh.normal_indices.size();
+        h.counts[5] = mesh.uv_indices.size();
+
+        std::vector<unsigned char> payload;
+        write(payload, mesh.vertices);
+        write(payload, mesh.normals);
+        write(payload, mesh.uvs);
+        write(payload, mesh.indices);
+        write(payload, mesh.normal_indices);
+        write(payload, mesh.uv_indices);
+        h.checksum = hash_bytes(payload.data(), payload.size());
+
+        write_cache_file(file_for(hash), &h, sizeof(h), payload.data(), payload.size());
+    }
+
+private:
+    // vertices, normals, uvs, then the three index buffers (eight byte elements first so every buffer stays aligned)
+    static const int buffer_count = 6;
+
+    // file header, followed by the buffers
+    struct header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        uint64_t key;
+        uint64_t counts[buffer_count];
+        uint64_t checksum;
+    };
+
+    // bytes of one element of a buffer
+    static uint64_t element_size(int buffer)
+    {
+        static const uint64_t sizes[buffer_count] = {sizeof(vec3), sizeof(vec3), sizeof(double), sizeof(uint32_t), sizeof(uint32_t), sizeof(uint32_t)};
+
+        return sizes[buffer];
+    }
+
+    // copy count elements out of the file and step past them
+    template <typename T>
+    static void read(const unsigned char *&at, uint64_t count, std::vector<T> &to)
+    {
+        to.resize(size_t(count));
+        std::memcpy(to.data(), at, size_t(count) * sizeof(T));
+        at += count * sizeof(T);
+    }
+
+    // append the bytes of a buffer
+    template <typename T>
+    static void write(std::vector<unsigned char> &to, const std::vector<T> &from)
+    {
+        const unsigned char *bytes = reinterpret_cast<const unsigned char *>(from.data());
+        to.insert(to.end(), bytes, bytes + from.size() * sizeof(T));
+    }
+};
+
+#endif
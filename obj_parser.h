@@ -0,0 +1,427 @@
+#ifndef OBJ_PARSER_H
+#define OBJ_PARSER_H
+
+// header file for reading .obj files straight into the flat buffers of a triangle_mesh, the file is mapped into memory,
+// split into line aligned chunks that are parsed on separate threads, and the chunks are joined at the end
+// (large files keep their parsed buffers in a mesh_cache, so later runs skip the parse)
+
+// include
+#include "utility.h"
+#include "mapped_file.h"
+#include "triangle_mesh.h"
+#include "mesh_cache.h"
+
+#include <charconv>
+
+// obj_parser
+class obj_parser
+{
+public:
+    // threads used for parsing (0 uses every hardware thread)
+    int thread_count = 0;
+
+    // smallest piece of the file handed to one thread
+    size_t min_chunk_bytes = size_t(1) << 20;
+
+    // parsed buffers of large files, keyed by the file's bytes
+    mesh_cache cache;
+
+    // read the positions, normals, uvs, and faces (split into triangles) of the file into mesh
+    // returns false if the file cannot be read or holds indices outside its buffers
+    bool parse(const std::string &filename, triangle_mesh_data &mesh) const
+    {
+        mesh = triangle_mesh_data();
+        mapped_file file(filename);
+
+        if (!file.is_open())
+        {
+            debugger::getInstance().logToFile("Cannot find object file " + filename);
+            return false;
+        }
+
+        // a file parsed before comes straight from the cache
+        bool use_cache = cache.enabled && file.size() >= cache.min_file_bytes;
+        uint64_t hash = use_cache ? mesh_cache::key(file.data(), file.size()) : 0;
+
+        if (use_cache && cache.load(hash, mesh))
+        {
+            return true;
+        }
+
+        const char *begin = reinterpret_cast<const char *>(file.data());
+        const char *end = begin + file.size();
+
+        // cut the file at line ends so every chunk holds whole lines
+        size_t threads = thread_count > 0 ? size_t(thread_count) : std::max(1u, std::thread::hardware_concurrency());
+        size_t chunk_count = std::max<size_t>(1, std::min(threads, file.size() / std::max<size_t>(1, min_chunk_bytes)));
+        std::vector<const char *> cuts(chunk_count + 1, end);
+        cuts[0] = begin;
+
+        for (size_t i = 1; i < chunk_count; i++)
+        {
+            const char *cut = std::max(cuts[i - 1], begin + file.size() * i / chunk_count);
+
+            while (cut < end && *cut != '\n')
+            {
+                cut++;
+            }
+
+            cuts[i] = cut < end ? cut + 1 : end;
+        }
+
+        std::vector<chunk> chunks(chunk_count);
+
+        auto parse_one = [&](size_t i)
+        {
+            parse_chunk(cuts[i], cuts[i + 1], chunks[i]);
+        };
+
+        run(chunk_count, parse_one);
+
+        if (!join(chunks, mesh, filename))
+        {
+            return false;
+        }
+
+        if (use_cache)
+        {
+            cache.save(hash, mesh);
+        }
+
+        return true;
+    }
+
+private:
+    // corner of a face, indices as written in the file (0 when missing)
+    struct corner
+    {
+        long long position, uv, normal;
+    };
+
+    // what one thread read, face indices are resolved to global slots where possible and to relative + (slot counted
+    // from the start of this chunk) when they count back from the last element read
+    struct chunk
+    {
+        std::vector<point3> positions;
+        std::vector<vec3> normals;
+        std::vector<double> uvs;
+
+        std::vector<int64_t> indices, uv_indices, normal_indices;
+
+        size_t skipped_lines = 0;
+        bool missing_uvs = false, missing_normals = false;
+    };
+
+    // missing index marker
+    static const int64_t no_index = std::numeric_limits<int64_t>::max();
+
+    // offset of indices that still need the number of elements read by earlier chunks
+    static const int64_t relative = -(int64_t(1) << 62);
+
+    // call work(i) for every i in [0, count), one thread each (the calling thread takes the first)
+    template <typename Work>
+    static void run(size_t count, Work &&work)
+    {
+        std::vector<std::thread> pool;
+
+        for (size_t i = 1; i < count; i++)
+        {
+            pool.emplace_back(work, i);
+        }
+
+        if (count > 0)
+        {
+            work(0);
+        }
+
+        for (auto &thread : pool)
+        {
+            thread.join();
+        }
+    }
+
+    // skip spaces and tabs
+    static const char *skip_blanks(const char *p, const char *end)
+    {
+        while (p < end && (*p == ' ' || *p == '\t'))
+        {
+            p++;
+        }
+
+        return p;
+    }
+
+    // read between required and count doubles separated by blanks
+    static bool read_doubles(const char *&p, const char *end, double *values, int required, int count)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            p = skip_blanks(p, end);
+
+            if (i >= required && p >= end)
+            {
+                return true;
+            }
+
+            // from_chars does not take a leading plus sign
+            if (p < end && *p == '+')
+            {
+                p++;
+            }
+
+            auto result = std::from_chars(p, end, values[i]);
+
+            if (result.ec != std::errc())
+            {
+                return false;
+            }
+
+            p = result.ptr;
+        }
+
+        return true;
+    }
+
+    // read one v, v/vt, v//vn, or v/vt/vn corner
+    static bool read_corner(const char *&p, const char *end, corner &out)
+    {
+        out = corner{0, 0, 0};
+        long long *fields[3] = {&out.position, &out.uv, &out.normal};
+
+        for (int field = 0; field < 3; field++)
+        {
+            if (p < end && *p != '/' && *p != ' ' && *p != '\t')
+            {
+                auto result = std::from_chars(p, end, *fields[field]);
+
+                if (result.ec != std::errc() || *fields[field] == 0)
+                {
+                    return false;
+                }
+
+                p = result.ptr;
+            }
+
+            if (field < 2 && p < end && *p == '/')
+            {
+                p++;
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        return out.position != 0;
+    }
+
+    // turn a file index into a global slot, or into relative + chunk slot for indices counting back
+    static int64_t resolve(long long index, size_t read_so_far)
+    {
+        if (index > 0)
+        {
+            return index - 1;
+        }
+
+        return relative + static_cast<int64_t>(read_so_far) + index;
+    }
+
+    // parse the whole lines in [p, end)
+    static void parse_chunk(const char *p, const char *end, chunk &out)
+    {
+        std::vector<corner> corners;
+
+        while (p < end)
+        {
+            const char *line_end = static_cast<const char *>(std::memchr(p, '\n', end - p));
+            line_end = line_end ? line_end : end;
+
+            const char *q = skip_blanks(p, line_end);
+            const char *stop = line_end;
+
+            // drop the carriage return of windows line ends
+            if (stop > q && stop[-1] == '\r')
+            {
+                stop--;
+            }
+
+            // vertex data that cannot be read is kept as zeros so the indices after it still line up
+            if (q + 1 < stop && q[0] == 'v' && (q[1] == ' ' || q[1] == '\t'))
+            {
+                double v[3] = {0, 0, 0};
+                q += 1;
+
+                out.skipped_lines += !read_doubles(q, stop, v, 3, 3);
+                out.positions.push_back(point3(v[0], v[1], v[2]));
+            }
+
+            else if (q + 2 < stop && q[0] == 'v' && q[1] == 'n' && (q[2] == ' ' || q[2] == '\t'))
+            {
+                double v[3] = {0, 0, 0};
+                q += 2;
+
+                out.skipped_lines += !read_doubles(q, stop, v, 3, 3);
+                out.normals.push_back(vec3(v[0], v[1], v[2]));
+            }
+
+            // the v of a uv may be left out
+            else if (q + 2 < stop && q[0] == 'v' && q[1] == 't' && (q[2] == ' ' || q[2] == '\t'))
+            {
+                double v[2] = {0, 0};
+                q += 2;
+
+                out.skipped_lines += !read_doubles(q, stop, v, 1, 2);
+                out.uvs.push_back(v[0]);
+                out.uvs.push_back(v[1]);
+            }
+
+            else if (q + 1 < stop && q[0] == 'f' && (q[1] == ' ' || q[1] == '\t'))
+            {
+                corners.clear();
+                q += 1;
+                bool ok = true;
+
+                while (ok)
+                {
+                    q = skip_blanks(q, stop);
+
+                    if (q >= stop)
+                    {
+                        break;
+                    }
+
+                    corner c;
+                    ok = read_corner(q, stop, c);
+                    corners.push_back(c);
+                }
+
+                if (ok && corners.size() >= 3)
+                {
+                    add_face(corners, out);
+                }
+                else
+                {
+                    out.skipped_lines++;
+                }
+            }
+
+            p = line_end < end ? line_end + 1 : end;
+        }
+    }
+
+    // split a face into a fan of triangles
+    static void add_face(const std::vector<corner> &corners, chunk &out)
+    {
+        size_t positions = out.positions.size(), uvs = out.uvs.size() / 2, normals = out.normals.size();
+
+        for (size_t k = 1; k + 1 < corners.size(); k++)
+        {
+            const corner *triangle[3] = {&corners[0], &corners[k], &corners[k + 1]};
+
+            for (const corner *c : triangle)
+            {
+                out.indices.push_back(resolve(c->position, positions));
+                out.uv_indices.push_back(c->uv != 0 ? resolve(c->uv, uvs) : no_index);
+                out.normal_indices.push_back(c->normal != 0 ? resolve(c->normal, normals) : no_index);
+
+                out.missing_uvs |= c->uv == 0;
+                out.missing_normals |= c->normal == 0;
+            }
+        }
+    }
+
+    // give the chunk's indices their final slots, false if one falls outside [0, total)
+    static bool place_indices(const std::vector<int64_t> &from, size_t base, size_t total, uint32_t *to)
+    {
+        for (size_t i = 0; i < from.size(); i++)
+        {
+            int64_t index = from[i] >= 0 ? from[i] : static_cast<int64_t>(base) + (from[i] - relative);
+
+            if (index < 0 || static_cast<uint64_t>(index) >= total)
+            {
+                return false;
+            }
+
+            to[i] = static_cast<uint32_t>(index);
+        }
+
+        return true;
+    }
+
+    // join the chunks in file order into one set of buffers
+    bool join(std::vector<chunk> &chunks, triangle_mesh_data &mesh, const std::string &filename) const
+    {
+        size_t count = chunks.size();
+        std::vector<size_t> position_base(count + 1, 0), normal_base(count + 1, 0), uv_base(count + 1, 0), index_base(count + 1, 0);
+        bool with_uvs = true, with_normals = true;
+        size_t skipped_lines = 0;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            position_base[i + 1] = position_base[i] + chunks[i].positions.size();
+            normal_base[i + 1] = normal_base[i] + chunks[i].normals.size();
+            uv_base[i + 1] = uv_base[i] + chunks[i].uvs.size() / 2;
+            index_base[i + 1] = index_base[i] + chunks[i].indices.size();
+
+            with_uvs &= !chunks[i].missing_uvs;
+            with_normals &= !chunks[i].missing_normals;
+            skipped_lines += chunks[i].skipped_lines;
+        }
+
+        if (position_base[count] > std::numeric_limits<uint32_t>::max())
+        {
+            debugger::getInstance().logToFile("Object file " + filename + " has more vertices than a mesh can index");
+            return false;
+        }
+
+        mesh.vertices.resize(position_base[count]);
+        mesh.normals.resize(with_normals ? normal_base[count] : 0);
+        mesh.uvs.resize(with_uvs ? uv_base[count] * 2 : 0);
+        mesh.indices.resize(index_base[count]);
+        mesh.normal_indices.resize(with_normals ? index_base[count] : 0);
+        mesh.uv_indices.resize(with_uvs ? index_base[count] : 0);
+
+        std::vector<char> placed(count, 1);
+
+        auto join_one = [&](size_t i)
+        {
+            chunk &c = chunks[i];
+
+            std::copy(c.positions.begin(), c.positions.end(), mesh.vertices.begin() + position_base[i]);
+            placed[i] = place_indices(c.indices, position_base[i], position_base[count], mesh.indices.data() + index_base[i]);
+
+            if (with_normals)
+            {
+                std::copy(c.normals.begin(), c.normals.end(), mesh.normals.begin() + normal_base[i]);
+                placed[i] &= place_indices(c.normal_indices, normal_base[i], normal_base[count], mesh.normal_indices.data() + index_base[i]);
+            }
+
+            if (with_uvs)
+            {
+                std::copy(c.uvs.begin(), c.uvs.end(), mesh.uvs.begin() + 2 * uv_base[i]);
+                placed[i] &= place_indices(c.uv_indices, uv_base[i], uv_base[count], mesh.uv_indices.data() + index_base[i]);
+            }
+
+            // the chunk is no longer needed
+            c = chunk();
+        };
+
+        run(count, join_one);
+
+        if (skipped_lines > 0)
+        {
+            debugger::getInstance().logToFile("Object file " + filename + ": skipped " + std::to_string(skipped_lines) + " lines that could not be read");
+        }
+
+        if (std::find(placed.begin(), placed.end(), 0) != placed.end())
+        {
+            debugger::getInstance().logToFile("Object file " + filename + " has face indices outside its buffers");
+            mesh = triangle_mesh_data();
+            return false;
+        }
+
+        return true;
+    }
+};
+
+#endif
@@ -1,111 +1,79 @@
 #ifndef OBJECT_H
 #define OBJECT_H
 
-// header file to create a triangle mesh of either 3 or 4 face vertices using the OBJ_Loader.h utility and
-// given .obj file
+// header file to create a triangle mesh from the faces of a given .obj file (read with obj_parser.h), the mesh is
+// built once and placed in the world as instances
 
 // include
 #include "utility.h"
-#include "OBJ_Loader.h"
+#include "obj_parser.h"
 #include "material.h"
 #include "world.h"
 #include "triangle.h"
+#include "triangle_mesh.h"
+#include "instance.h"
 
 // object
 class object
 {
 public:
-    // constructor to create a triangle mesh object with given name
+    // constructor to create a triangle mesh object with given name, the file is read once into flat buffers
     object(const char *filename) : filename(filename)
     {
-        // open file
-        std::ifstream object_file(filename);
+        obj_parser().parse(filename, data);
+    }
+
+    // create object inside the world on the given center point
+    // (every call places the same shared mesh, so more copies only cost one instance each)
+    void create_object(world *world, point3 center, double scale)
+    {
+        create_instance(world, affine_transform::scale(scale) * affine_transform::translate(center));
+    }
 
-        if (!object_file.is_open())
+    // place the shared mesh in the world with any object to world transform
+    void create_instance(world *world, const affine_transform &transform)
+    {
+        if (mesh()->objects.empty())
         {
-            debugger::getInstance().logToFile("Cannot find object file");
+            debugger::getInstance().logToFile("Object file " + filename + " has no faces to place");
             return;
         }
 
-        // find faces of the object and each mesh
-        std::string line;
+        world->add(world->make_object<instance>(mesh(), transform));
+    }
 
-        while (std::getline(object_file, line))
+    // the mesh of the .obj file in object space, with its own hierarchy, built on first use
+    shared_ptr<::world> mesh()
+    {
+        if (!mesh_world)
         {
-            if (!line.empty() && line[0] == 'f')
-            {
-                std::istringstream iss(line);
-                std::string part;
-
-                int partCount = -1;
-
-                while (iss >> part)
-                {
-                    partCount++;
-                }
-
-                if (partCount > 0)
-                {
-                    face_vertice_count.push_back(partCount);
-                }
-            }
+            mesh_world = make_shared<::world>();
+            build_mesh(*mesh_world);
         }
 
-        object_file.close();
-        loader.LoadFile(filename);
+        return mesh_world;
     }
 
-    // create object inside the world on the given center point
-    void create_object(world *world, point3 center, double scale)
+private:
+    triangle_mesh_data data;
+    shared_ptr<::world> mesh_world;
+    std::string filename;
+
+    // add the faces of the .obj file to the given world as one indexed triangle_mesh
+    void build_mesh(::world &target)
     {
         // default material
         auto blue = make_shared<diffuse>(color(.2, .2, 1));
 
-        int face_index = 0;
-
-        // loop over .obj file and add shape to entire object
-        for (int i = 0; i < loader.LoadedMeshes.size(); i++)
+        if (data.indices.empty())
         {
-            objl::Mesh current_mesh = loader.LoadedMeshes[i];
-
-            // go over each mesh vertices
-            for (int j = 0; j < current_mesh.Vertices.size();)
-            {
-                int face_size = face_vertice_count[face_index];
-
-                point3 one = point3(current_mesh.Vertices[j].Position.X, current_mesh.Vertices[j].Position.Y, current_mesh.Vertices[j].Position.Z);
-                one += center;
-
-                // loop over face size and get points for each face by splitting into triangles
-                for (int k = 1; k < (face_size-1); k++)
-                {
-                    int two_index = j + k;
-                    int three_index = j + (k + 1);
-
-                    debugger::getInstance().logToFile(std::to_string(j));
-                    debugger::getInstance().logToFile(std::to_string(two_index));
-                    debugger::getInstance().logToFile(std::to_string(three_index));
-                    debugger::getInstance().logToFile("---------------");
-
-                    point3 two = point3(current_mesh.Vertices[two_index].Position.X, current_mesh.Vertices[two_index].Position.Y, current_mesh.Vertices[two_index].Position.Z);
-                    two += center;
-
-                    point3 three = point3(current_mesh.Vertices[three_index].Position.X, current_mesh.Vertices[three_index].Position.Y, current_mesh.Vertices[three_index].Position.Z);
-                    three += center;
-
-                    world->add(make_shared<triangle>(1, one*scale, two*scale, three*scale, blue));
-                }
-
-                j += face_size;
-                face_index++;
-            }
+            return;
         }
-    }
 
-private:
-    objl::Loader loader;
-    std::string filename;
-    std::vector<int> face_vertice_count;
+        // the buffers are moved into the mesh, it is only built once
+        target.add(make_shared<triangle_mesh>(std::move(data), blue, target.bvh_settings, target.bvh_disk_cache));
+        data = triangle_mesh_data();
+    }
 };
 
 #endif
\ No newline at end of file
@@ -66,6 +66,17 @@ public:
         return std::fabs(accum);
     }
 
+    // hash of the noise tables
+    uint64_t fingerprint() const
+    {
+        uint64_t hash = hash_bytes(reinterpret_cast<const unsigned char *>(perm_x), sizeof(perm_x));
+        hash = hash_combine(hash, hash_bytes(reinterpret_cast<const unsigned char *>(perm_y), sizeof(perm_y)));
+        hash = hash_combine(hash, hash_bytes(reinterpret_cast<const unsigned char *>(perm_z), sizeof(perm_z)));
+        hash = hash_combine(hash, hash_bytes(reinterpret_cast<const unsigned char *>(randfloat), sizeof(randfloat)));
+
+        return hash_combine(hash, hash_bytes(reinterpret_cast<const unsigned char *>(randvec), sizeof(randvec)));
+    }
+
 private:
     static const int number_of_points = 256;
     int perm_x[number_of_points], perm_y[number_of_points], perm_z[number_of_points];
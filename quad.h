@@ -92,15 +92,21 @@ public:
             return false;
         }
 
-        // place intersect variables
+        // place intersect variables (in_quad already set the uv)
         rec.t = t;
-        rec.p = intersection;
-        rec.mat = mat;
-        rec.set_face_normal(r, normal);
+        rec.object = this;
 
         return true;
     }
 
+    // function to fill in the point and normal of the closest hit
+    void set_hit(const ray &r, place_hit &rec) const override
+    {
+        rec.p = r.at(rec.t);
+        rec.mat = mat.get();
+        rec.set_face_normal(r, normal);
+    }
+
     // function to determine if intersect point is in the quad
     virtual bool in_quad(double a, double b, place_hit &rec) const
     {
@@ -132,6 +138,42 @@ public:
         return aa_bound_box;
     }
 
+    // hash of the corner, the edges, and the material
+    uint64_t fingerprint() const override
+    {
+        uint64_t hash = hash_combine(box_fingerprint(), material_fingerprint(mat.get()));
+        const vec3 shape[] = {Q, u, v};
+
+        for (const vec3 &p : shape)
+        {
+            hash = hash_double(hash_double(hash_double(hash, p.x()), p.y()), p.z());
+        }
+
+        return hash;
+    }
+
+    // pdf of a uniform point on the quad, turned from area into the solid angle seen from origin
+    double pdf_value(const point3 &origin, const vec3 &direction, double) const override
+    {
+        place_hit rec;
+
+        if (!intersect(ray(origin, direction), interval(0.001, infinity), rec))
+        {
+            return 0;
+        }
+
+        double distance_squared = rec.t * rec.t * direction.length_squared();
+        double cosine = std::fabs(dot(direction, normal)) / direction.length();
+
+        return distance_squared / (cosine * cross(u, v).length());
+    }
+
+    // direction from origin to a uniform point on the quad
+    vec3 random(const point3 &origin, double) const override
+    {
+        return Q + (random_double() * u) + (random_double() * v) - origin;
+    }
+
 private:
     int differ;
     double D;
@@ -0,0 +1,76 @@
+#ifndef RNG_H
+#define RNG_H
+
+// header file for the random number generator used by every random_double() call
+
+// include
+#include "utility.h"
+
+// mix the bits of a 64 bit value (splitmix64 finalizer), spreads nearby seeds over the whole state space and is
+// the base of the hashes in utility.h
+inline uint64_t hash_mix(uint64_t x)
+{
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+
+    return x ^ (x >> 31);
+}
+
+// pcg32 (PCG-XSH-RR, 64 bits of state, 32 bit output)
+class pcg32
+{
+public:
+    // constructor with a seed and a stream, generators on different streams never overlap
+    pcg32(uint64_t seed = 0x853c49e6748fea9bULL, uint64_t stream = 0xda3e39cb94b95bdbULL)
+    {
+        set_seed(seed, stream);
+    }
+
+    // restart the generator at the given seed and stream
+    void set_seed(uint64_t seed, uint64_t stream)
+    {
+        state = 0;
+        inc = (stream << 1) | 1;
+        next_uint();
+        state += seed;
+        next_uint();
+    }
+
+    // restart the generator for one pixel, starting at the given sample index
+    // the sequence only depends on the render seed and the pixel, never on which thread draws it
+    void seed_pixel(uint64_t render_seed, uint64_t pixel_index, uint64_t first_sample = 0)
+    {
+        set_seed(hash_mix(render_seed ^ hash_mix(pixel_index) ^ hash_mix(first_sample + 0x9e3779b97f4a7c15ULL)), pixel_index);
+    }
+
+    // next 32 bit random value
+    uint32_t next_uint()
+    {
+        uint64_t old_state = state;
+        state = old_state * 6364136223846793005ULL + inc;
+
+        uint32_t xorshifted = static_cast<uint32_t>(((old_state >> 18u) ^ old_state) >> 27u);
+        uint32_t rot = static_cast<uint32_t>(old_state >> 59u);
+
+        return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+    }
+
+    // next random double in [0, 1)
+    double next_double()
+    {
+        return next_uint() * (1.0 / 4294967296.0);
+    }
+
+private:
+    uint64_t state, inc;
+};
+
+// the generator of the calling thread
+inline pcg32 &thread_rng()
+{
+    thread_local pcg32 generator;
+
+    return generator;
+}
+
+#endif
@@ -0,0 +1,168 @@
+#ifndef SCENE_ARENA_H
+#define SCENE_ARENA_H
+
+// header file for the memory a scene's primitives, materials, and textures are built in, handed out from large blocks
+// one category at a time so objects of a kind sit next to each other, and given back all at once with the scene
+
+// include
+#include "utility.h"
+
+#include <new>
+
+// what an arena allocation is used for, every category has its own blocks
+enum class arena_category
+{
+    primitives,
+    materials,
+    textures,
+    count
+};
+
+// numbers of one category of an arena
+struct arena_usage
+{
+    size_t objects = 0;
+    // bytes handed out, including alignment padding
+    size_t bytes = 0;
+    // bytes of the blocks the category has taken from the heap
+    size_t reserved = 0;
+};
+
+// shared pointer to an object in an arena that does not own it, objects in the same arena point at each other this way
+// so they cost no reference counting and cannot keep their own arena alive
+template <typename T>
+shared_ptr<T> arena_pointer(T *object)
+{
+    return shared_ptr<T>(shared_ptr<T>(), object);
+}
+
+// scene_arena
+class scene_arena
+{
+public:
+    // size of the blocks taken from the heap, bigger objects get a block of their own
+    static const size_t block_size = 64 * 1024;
+
+    // constructors
+    scene_arena() {}
+    scene_arena(const scene_arena &) = delete;
+    scene_arena &operator=(const scene_arena &) = delete;
+
+    // destroy every object, newest first, then give the blocks back
+    ~scene_arena()
+    {
+        for (size_t i = destructors.size(); i > 0; i--)
+        {
+            destructors[i - 1].destroy(destructors[i - 1].object);
+        }
+
+        for (auto &blocks : categories)
+        {
+            for (block &b : blocks.blocks)
+            {
+                ::operator delete(b.data, std::align_val_t(block_alignment));
+            }
+        }
+    }
+
+    // construct a T in the blocks of the given category, it lives as long as the arena
+    template <typename T, typename... Args>
+    T *create(arena_category category, Args &&...args)
+    {
+        static_assert(alignof(T) <= block_alignment, "arena objects can be aligned to at most a cache line");
+
+        void *memory = allocate(category, sizeof(T), alignof(T));
+        T *object = new (memory) T(std::forward<Args>(args)...);
+
+        // objects that need no destructor are just dropped with their block
+        if constexpr (!std::is_trivially_destructible<T>::value)
+        {
+            destructors.push_back({object, [](void *p) { static_cast<T *>(p)->~T(); }});
+        }
+
+        categories[size_t(category)].usage.objects++;
+
+        return object;
+    }
+
+    // numbers of one category
+    const arena_usage &usage(arena_category category) const
+    {
+        return categories[size_t(category)].usage;
+    }
+
+    // one line per category, for logs
+    std::string report() const
+    {
+        static const char *names[] = {"primitives", "materials", "textures"};
+        std::string text;
+
+        for (size_t i = 0; i < size_t(arena_category::count); i++)
+        {
+            const arena_usage &u = categories[i].usage;
+            text += std::string(names[i]) + ": " + std::to_string(u.objects) + " objects, " + std::to_string(u.bytes / 1024) + " KB used of " +
+                    std::to_string(u.reserved / 1024) + " KB\n";
+        }
+
+        return text;
+    }
+
+private:
+    // blocks start on a cache line
+    static const size_t block_alignment = 64;
+
+    // one block of memory and how much of it is handed out
+    struct block
+    {
+        unsigned char *data;
+        size_t size, used;
+    };
+
+    // blocks and numbers of one category
+    struct category_blocks
+    {
+        std::vector<block> blocks;
+        arena_usage usage;
+    };
+
+    // object whose destructor runs with the arena
+    struct destructor
+    {
+        void *object;
+        void (*destroy)(void *);
+    };
+
+    category_blocks categories[size_t(arena_category::count)];
+    std::vector<destructor> destructors;
+
+    // bump size bytes out of the category's newest block, starting a new block when it is full
+    void *allocate(arena_category category, size_t size, size_t alignment)
+    {
+        category_blocks &c = categories[size_t(category)];
+
+        if (!c.blocks.empty())
+        {
+            block &last = c.blocks.back();
+            size_t start = (last.used + alignment - 1) & ~(alignment - 1);
+
+            if (start + size <= last.size)
+            {
+                c.usage.bytes += start + size - last.used;
+                last.used = start + size;
+
+                return last.data + start;
+            }
+        }
+
+        size_t new_size = std::max(block_size, size);
+        block b{static_cast<unsigned char *>(::operator new(new_size, std::align_val_t(block_alignment))), new_size, size};
+
+        c.blocks.push_back(b);
+        c.usage.bytes += size;
+        c.usage.reserved += new_size;
+
+        return b.data;
+    }
+};
+
+#endif
@@ -83,17 +83,79 @@ public:
 
     // place intersect variables for further calculations
     rec.t = root;
+    rec.object = this;
+
+    return true;
+  }
+
+  // function to fill in the point, normal, and uv of the closest hit
+  void set_hit(const ray &r, place_hit &rec) const override
+  {
     rec.p = r.at(rec.t);
-    vec3 outward_normal = (rec.p - current_center) / radius;
+    vec3 outward_normal = (rec.p - center.at(r.time())) / radius;
     rec.set_face_normal(r, outward_normal);
     get_sphere_uv(outward_normal, rec.u, rec.v);
-    rec.mat = mat;
-
-    return true;
+    rec.mat = mat.get();
   }
 
   AA_bounding_box bounding_box() const override { return aa_bound_box; }
 
+  // hash of the box (which holds the center and radius at both ends of the move) and the material
+  uint64_t fingerprint() const override
+  {
+    return hash_combine(box_fingerprint(), material_fingerprint(mat.get()));
+  }
+
+  // pdf of the cone of directions the sphere covers from origin (uniform over all directions from inside it), with
+  // the sphere where it is at the given time so moving lights are sampled where the shadow ray meets them
+  double pdf_value(const point3 &origin, const vec3 &direction, double time) const override
+  {
+    double distance_squared = (center.at(time) - origin).length_squared();
+
+    if (distance_squared <= radius * radius)
+    {
+      return 1 / (4 * pi);
+    }
+
+    place_hit rec;
+
+    if (!intersect(ray(origin, direction, time), interval(0.001, infinity), rec))
+    {
+      return 0;
+    }
+
+    double cos_theta_max = std::sqrt(1 - radius * radius / distance_squared);
+
+    return 1 / (2 * pi * (1 - cos_theta_max));
+  }
+
+  // random direction inside the cone the sphere covers from origin at the given time
+  vec3 random(const point3 &origin, double time) const override
+  {
+    vec3 direction = center.at(time) - origin;
+    double distance_squared = direction.length_squared();
+
+    if (distance_squared <= radius * radius)
+    {
+      return random_unit_vector();
+    }
+
+    // cone sample around the z axis, then turned to point at the center
+    double r1 = random_double();
+    double r2 = random_double();
+    double cos_theta_max = std::sqrt(1 - radius * radius / distance_squared);
+    double z = 1 + r2 * (cos_theta_max - 1);
+    double phi = 2 * pi * r1;
+    double sin_theta = std::sqrt(1 - z * z);
+
+    vec3 w = unit_vector(direction);
+    vec3 a = std::fabs(w.x()) > 0.9 ? vec3(0, 1, 0) : vec3(1, 0, 0);
+    vec3 v = unit_vector(cross(w, a));
+    vec3 u = cross(w, v);
+
+    return std::cos(phi) * sin_theta * u + std::sin(phi) * sin_theta * v + z * w;
+  }
+
 private:
   double radius;
   ray center;
@@ -6,13 +6,16 @@
 // include
 #include "utility.h"
 #include "AA_bounding_box.h"
-#include "world.h"
+#include "bvh_build.h"
+
+// world (defined in world.h, which builds its own structure from this header)
+class world;
 
 class spatial_sub_acc_struct : public hittable
 {
 public:
-    // constructor for with given world
-    spatial_sub_acc_struct(world list) : spatial_sub_acc_struct(list.objects, 0, list.objects.size()) {}
+    // constructor for with given world, built with the world's settings (defined in world.h)
+    spatial_sub_acc_struct(const world &list);
 
     // constructor for vector of hittable objects
     spatial_sub_acc_struct(std::vector<shared_ptr<hittable>> &objects, size_t start, size_t end)
@@ -42,12 +45,14 @@ public:
         if (object_span == 1)
         {
             left = right = objects[start];
+            cost = 1;
         }
 
         else if (object_span == 2)
         {
             left = objects[start];
             right = objects[start + 1];
+            cost = bvh_node_cost(bvh_build_settings(), aa_bound_box, left->bounding_box(), 1, right->bounding_box(), 1);
         }
 
         else
@@ -55,11 +60,31 @@ public:
             std::sort(std::begin(objects) + start, std::begin(objects) + end, comparator);
 
             auto mid = start + object_span / 2;
-            left = make_shared<spatial_sub_acc_struct>(objects, start, mid);
-            right = make_shared<spatial_sub_acc_struct>(objects, mid, end);
+            auto left_node = make_shared<spatial_sub_acc_struct>(objects, start, mid);
+            auto right_node = make_shared<spatial_sub_acc_struct>(objects, mid, end);
+
+            cost = bvh_node_cost(bvh_build_settings(), aa_bound_box, left_node->aa_bound_box, left_node->cost, right_node->aa_bound_box, right_node->cost);
+            left = left_node;
+            right = right_node;
         }
     }
 
+    // constructor for vector of hittable objects split by the given build settings
+    spatial_sub_acc_struct(const std::vector<shared_ptr<hittable>> &objects, const bvh_build_settings &settings)
+    {
+        std::vector<bvh_primitive> refs = make_bvh_primitives(objects, settings);
+
+        if (refs.empty())
+        {
+            aa_bound_box = AA_bounding_box::empty;
+            cost = 0;
+            return;
+        }
+
+        bvh_thread_budget budget(bvh_build_threads(settings));
+        build(objects, refs, 0, refs.size(), settings, budget);
+    }
+
     bool intersect(const ray &r, interval ray_t, place_hit &rec) const override
     {
         if (!aa_bound_box.intersect(r, ray_t))
@@ -67,6 +92,28 @@ public:
             return false;
         }
 
+        // leaf with more than two objects
+        if (!leaf_objects.empty())
+        {
+            bool is_hit = false;
+
+            for (const auto &object : leaf_objects)
+            {
+                if (object->intersect(r, ray_t, rec))
+                {
+                    is_hit = true;
+                    ray_t.max = rec.t;
+                }
+            }
+
+            return is_hit;
+        }
+
+        if (!left)
+        {
+            return false;
+        }
+
         bool hit_left = left->intersect(r, ray_t, rec);
         bool hit_right = right->intersect(r, interval(ray_t.min, hit_left ? rec.t : ray_t.max), rec);
 
@@ -75,11 +122,80 @@ public:
 
     AA_bounding_box bounding_box() const override { return aa_bound_box; }
 
+    // expected cost of a ray through the tree under the surface area heuristic,
+    // counted in object intersections (lower is a better tree)
+    double sah_cost() const { return cost; }
+
 private:
     shared_ptr<hittable> left;
     shared_ptr<hittable> right;
+    std::vector<shared_ptr<hittable>> leaf_objects;
 
     AA_bounding_box aa_bound_box;
+    double cost = 0;
+
+    // empty node filled in by build
+    spatial_sub_acc_struct() {}
+
+    // build the node over the references in [start, end)
+    void build(const std::vector<shared_ptr<hittable>> &objects, std::vector<bvh_primitive> &refs, size_t start, size_t end,
+               const bvh_build_settings &settings, bvh_thread_budget &budget)
+    {
+        bvh_split split = bvh_choose_split(refs, start, end, settings, budget);
+        aa_bound_box = split.box;
+
+        if (split.leaf)
+        {
+            cost = settings.intersection_cost * (end - start);
+
+            if (end - start == 1)
+            {
+                left = right = objects[refs[start].index];
+                return;
+            }
+
+            for (size_t i = start; i < end; i++)
+            {
+                leaf_objects.push_back(objects[refs[i].index]);
+            }
+
+            return;
+        }
+
+        // the two halves touch disjoint ranges of refs, so large ones can be built on two threads
+        double left_cost, right_cost;
+
+        auto build_left = [&]()
+        {
+            left = build_child(objects, refs, start, split.mid, settings, budget, left_cost);
+        };
+
+        auto build_right = [&]()
+        {
+            right = build_child(objects, refs, split.mid, end, settings, budget, right_cost);
+        };
+
+        bvh_fork_join(budget, settings, end - start, build_left, build_right);
+
+        cost = bvh_node_cost(settings, aa_bound_box, left->bounding_box(), left_cost, right->bounding_box(), right_cost);
+    }
+
+    // build a child, a single object is used as the child directly
+    static shared_ptr<hittable> build_child(const std::vector<shared_ptr<hittable>> &objects, std::vector<bvh_primitive> &refs, size_t start, size_t end,
+                                            const bvh_build_settings &settings, bvh_thread_budget &budget, double &child_cost)
+    {
+        if (end - start == 1)
+        {
+            child_cost = settings.intersection_cost;
+            return objects[refs[start].index];
+        }
+
+        shared_ptr<spatial_sub_acc_struct> node(new spatial_sub_acc_struct());
+        node->build(objects, refs, start, end, settings, budget);
+        child_cost = node->cost;
+
+        return node;
+    }
 
     static bool box_compare(
         const shared_ptr<hittable> a, const shared_ptr<hittable> b, int axis_index)
@@ -7,19 +7,54 @@
 #include "utility.h"
 #include "image_loader.h"
 
+// the built in textures, a texture's type lets texture_value call it without a virtual call
+enum class texture_type
+{
+  solid,
+  sunset,
+  rainbow,
+  image,
+  hashed,
+  perlin,
+  // any other texture, called through value
+  custom
+};
+
 // texture
 class texture
 {
 public:
+  // which built in texture this is
+  const texture_type type;
+
+  texture() : type(texture_type::custom) {}
+
   virtual color value(double u, double v, const point3 &p) const = 0;
+
+  // hash of what the texture looks like, used to check that a saved render belongs to the same scene (other textures
+  // only count by their type)
+  virtual uint64_t fingerprint() const
+  {
+    return hash_combine(0, uint64_t(type));
+  }
+
+protected:
+  // fold a color into a texture hash
+  static uint64_t hash_color(uint64_t hash, const color &c)
+  {
+    return hash_double(hash_double(hash_double(hash, c.x()), c.y()), c.z());
+  }
+
+  // constructor for the built in textures
+  texture(texture_type type) : type(type) {}
 };
 
 // solid color texture
-class solid_color : public texture
+class solid_color final : public texture
 {
 public:
   // constructor for with color class
-  solid_color(const color &solid_c) : solid_c(solid_c) {}
+  solid_color(const color &solid_c) : texture(texture_type::solid), solid_c(solid_c) {}
 
   // constructor for with rgb values
   solid_color(double red, double green, double blue) : solid_color(color(red, green, blue)) {}
@@ -30,16 +65,22 @@ public:
     return solid_c;
   }
 
+  // hash of the color
+  uint64_t fingerprint() const override
+  {
+    return hash_color(texture::fingerprint(), solid_c);
+  }
+
 private:
   color solid_c;
 };
 
 // sunset texture
-class sunset : public texture
+class sunset final : public texture
 {
 public:
   // constructor for sunset with max and min height of the object
-  sunset(double max, double min) : max(max), min(min) {}
+  sunset(double max, double min) : texture(texture_type::sunset), max(max), min(min) {}
 
   // get color value
   color value(double u, double v, const point3 &p) const override
@@ -69,16 +110,22 @@ public:
     return color(r, g, b);
   }
 
+  // hash of the heights
+  uint64_t fingerprint() const override
+  {
+    return hash_double(hash_double(texture::fingerprint(), max), min);
+  }
+
 private:
   double max, min;
 };
 
 // rainbow texture
-class rainbow : public texture
+class rainbow final : public texture
 {
 public:
   // constructor for rainbow using max and min height of the shapes
-  rainbow(double max, double min) : max(max), min(min) {}
+  rainbow(double max, double min) : texture(texture_type::rainbow), max(max), min(min) {}
 
   // return the color value
   color value(double u, double v, const point3 &p) const override
@@ -127,16 +174,22 @@ public:
     }
   }
 
+  // hash of the heights
+  uint64_t fingerprint() const override
+  {
+    return hash_double(hash_double(texture::fingerprint(), max), min);
+  }
+
 private:
   double max, min;
 };
 
 // custom image texture
-class image_texture : public texture
+class image_texture final : public texture
 {
 public:
   // constructor for taking a file name and using it as the  texture
-  image_texture(const char *filename) : image(filename) {}
+  image_texture(const char *filename) : texture(texture_type::image), image(filename) {}
 
   // return the color value
   color value(double u, double v, const point3 &p) const override
@@ -154,16 +207,22 @@ public:
     return color(color_scale * pixel[0], color_scale * pixel[1], color_scale * pixel[2]);
   }
 
+  // hash of the image
+  uint64_t fingerprint() const override
+  {
+    return hash_combine(texture::fingerprint(), image.fingerprint());
+  }
+
 private:
   image_loader image;
 };
 
 // hashed texture
-class hashed : public texture
+class hashed final : public texture
 {
 public:
   // constructor for hashed texture with given color
-  hashed(color solid_c) : solid_c(solid_c)
+  hashed(color solid_c) : texture(texture_type::hashed), solid_c(solid_c)
   {
     for (int i = 0; i < point_count; i++)
     {
@@ -188,6 +247,17 @@ public:
     return solid_c * randfloat[hash_x[i] ^ hash_y[j] ^ hash_z[k]];
   }
 
+  // hash of the color and the random tables
+  uint64_t fingerprint() const override
+  {
+    uint64_t hash = hash_color(texture::fingerprint(), solid_c);
+    hash = hash_combine(hash, hash_bytes(reinterpret_cast<const unsigned char *>(randfloat), sizeof(randfloat)));
+    hash = hash_combine(hash, hash_bytes(reinterpret_cast<const unsigned char *>(hash_x), sizeof(hash_x)));
+    hash = hash_combine(hash, hash_bytes(reinterpret_cast<const unsigned char *>(hash_y), sizeof(hash_y)));
+
+    return hash_combine(hash, hash_bytes(reinterpret_cast<const unsigned char *>(hash_z), sizeof(hash_z)));
+  }
+
 private:
   color solid_c;
 
@@ -217,22 +287,54 @@ private:
 };
 
 // perlin noise texture
-class perlin_noise : public texture
+class perlin_noise final : public texture
 {
 public:
   // constructor for perline noise given a scale and a color to solid_c
-  perlin_noise(double scale, color solid_c) : scale(scale), solid_c(solid_c) {}
+  perlin_noise(double scale, color solid_c) : texture(texture_type::perlin), scale(scale), noise(make_shared<perlin>()), solid_c(solid_c) {}
+
+  // constructor for perlin noise that shares a noise table with other textures
+  perlin_noise(double scale, color solid_c, shared_ptr<perlin> noise) : texture(texture_type::perlin), scale(scale), noise(noise), solid_c(solid_c) {}
 
   // return the color value
   color value(double u, double v, const point3 &p) const override
   {
-    return solid_c * (1 + std::sin(scale * p.z() + 10 * noise.create_turbulence(p, 7)));
+    return solid_c * (1 + std::sin(scale * p.z() + 10 * noise->create_turbulence(p, 7)));
+  }
+
+  // hash of the scale, the color, and the noise table
+  uint64_t fingerprint() const override
+  {
+    return hash_combine(hash_color(hash_double(texture::fingerprint(), scale), solid_c), noise->fingerprint());
   }
 
 private:
   double scale;
-  perlin noise;
+  shared_ptr<perlin> noise;
   color solid_c;
 };
 
+// value of a texture, switching over the built in ones so their final value functions are called directly (and can be
+// inlined), any other texture goes through the virtual call
+inline color texture_value(const texture &tex, double u, double v, const point3 &p)
+{
+  switch (tex.type)
+  {
+  case texture_type::solid:
+    return static_cast<const solid_color &>(tex).solid_color::value(u, v, p);
+  case texture_type::sunset:
+    return static_cast<const sunset &>(tex).sunset::value(u, v, p);
+  case texture_type::rainbow:
+    return static_cast<const rainbow &>(tex).rainbow::value(u, v, p);
+  case texture_type::image:
+    return static_cast<const image_texture &>(tex).image_texture::value(u, v, p);
+  case texture_type::hashed:
+    return static_cast<const hashed &>(tex).hashed::value(u, v, p);
+  case texture_type::perlin:
+    return static_cast<const perlin_noise &>(tex).perlin_noise::value(u, v, p);
+  default:
+    return tex.value(u, v, p);
+  }
+}
+
 #endif
\ No newline at end of file
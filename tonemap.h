@@ -0,0 +1,66 @@
+#ifndef TONEMAP_H
+#define TONEMAP_H
+
+// header file for turning linear radiance into display bytes, kept apart from rendering so the same linear image can
+// be exposed and encoded again without rendering it again
+
+// include
+#include "utility.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TONEMAP_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// settings of the display transform
+struct tonemap_settings
+{
+    // linear scale applied before the gamma curve
+    float exposure = 1.0f;
+};
+
+// one channel: exposure, gamma 2, clamp to [0, 0.999], and scale to a byte
+inline unsigned char tonemap_channel(float value, float exposure)
+{
+    float scaled = value * exposure;
+    float encoded = scaled > 0 ? std::sqrt(scaled) : 0.0f;
+
+    return static_cast<unsigned char>(256.0f * std::min(encoded, 0.999f));
+}
+
+// map count linear values to bytes, sixteen at a time with sse2 where the cpu has it
+inline void tonemap_to_bytes(const float *linear, unsigned char *out, size_t count, const tonemap_settings &settings = tonemap_settings())
+{
+    size_t i = 0;
+
+#if defined(TONEMAP_SSE2)
+    const __m128 exposure = _mm_set1_ps(settings.exposure);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 top = _mm_set1_ps(0.999f);
+    const __m128 scale = _mm_set1_ps(256.0f);
+
+    // max(x, 0) also turns nan into 0, like the scalar path
+    auto to_int = [&](const float *p)
+    {
+        __m128 v = _mm_max_ps(_mm_mul_ps(_mm_loadu_ps(p), exposure), zero);
+        v = _mm_min_ps(_mm_sqrt_ps(v), top);
+
+        return _mm_cvttps_epi32(_mm_mul_ps(v, scale));
+    };
+
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i low = _mm_packs_epi32(to_int(linear + i), to_int(linear + i + 4));
+        __m128i high = _mm_packs_epi32(to_int(linear + i + 8), to_int(linear + i + 12));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi16(low, high));
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        out[i] = tonemap_channel(linear[i], settings.exposure);
+    }
+}
+
+#endif
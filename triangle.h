@@ -94,15 +94,21 @@ public:
             return false;
         }
 
-        // set the place intersect record
+        // set the place intersect record (in_triangle already set the uv)
         rec.t = t;
-        rec.p = intersection;
-        rec.mat = mat;
-        rec.set_face_normal(r, normal);
+        rec.object = this;
 
         return true;
     }
 
+    // fill in the point and normal of the closest hit
+    void set_hit(const ray &r, place_hit &rec) const override
+    {
+        rec.p = r.at(rec.t);
+        rec.mat = mat.get();
+        rec.set_face_normal(r, normal);
+    }
+
     // see if it hits the triangle, if not return false
     virtual bool in_triangle(double a, double b, place_hit &rec) const
     {
@@ -131,6 +137,51 @@ public:
         return aa_bound_box;
     }
 
+    // hash of the corner, the edges, and the material
+    uint64_t fingerprint() const override
+    {
+        uint64_t hash = hash_combine(box_fingerprint(), material_fingerprint(mat.get()));
+        const vec3 shape[] = {Q, u, v};
+
+        for (const vec3 &p : shape)
+        {
+            hash = hash_double(hash_double(hash_double(hash, p.x()), p.y()), p.z());
+        }
+
+        return hash;
+    }
+
+    // pdf of a uniform point on the triangle, turned from area into the solid angle seen from origin
+    double pdf_value(const point3 &origin, const vec3 &direction, double) const override
+    {
+        place_hit rec;
+
+        if (!intersect(ray(origin, direction), interval(0.001, infinity), rec))
+        {
+            return 0;
+        }
+
+        double distance_squared = rec.t * rec.t * direction.length_squared();
+        double cosine = std::fabs(dot(direction, normal)) / direction.length();
+
+        return distance_squared / (cosine * 0.5 * cross(u, v).length());
+    }
+
+    // direction from origin to a uniform point on the triangle (points past the diagonal are folded back)
+    vec3 random(const point3 &origin, double) const override
+    {
+        double a = random_double();
+        double b = random_double();
+
+        if (a + b > 1)
+        {
+            a = 1 - a;
+            b = 1 - b;
+        }
+
+        return Q + (a * u) + (b * v) - origin;
+    }
+
 private:
     int differ, debug;
     double D;
@@ -0,0 +1,330 @@
+#ifndef TRIANGLE_MESH_H
+#define TRIANGLE_MESH_H
+
+// header file for an indexed triangle mesh, the triangles share one vertex buffer, one material, and one hierarchy
+// whose leaves point straight at triangle numbers
+
+// include
+#include "utility.h"
+#include "linear_bvh.h"
+#include "bvh_cache.h"
+
+// buffers of a mesh, three indices per triangle, normals and uvs are optional and have their own indices
+struct triangle_mesh_data
+{
+    std::vector<point3> vertices;
+    std::vector<uint32_t> indices;
+
+    std::vector<vec3> normals;
+    std::vector<uint32_t> normal_indices;
+
+    // two values (u, v) per uv
+    std::vector<double> uvs;
+    std::vector<uint32_t> uv_indices;
+};
+
+// triangle_mesh
+class triangle_mesh : public hittable
+{
+public:
+    // build the mesh and its hierarchy from the buffers, all triangles use the given material
+    triangle_mesh(triangle_mesh_data data, shared_ptr<material> mat, const bvh_build_settings &settings = bvh_build_settings(),
+                  const bvh_cache &cache = bvh_cache())
+        : mesh(std::move(data)), mat(mat)
+    {
+        if (!valid())
+        {
+            debugger::getInstance().logToFile("triangle_mesh has indices outside its buffers, mesh left empty");
+            mesh = triangle_mesh_data();
+        }
+
+        build(settings, cache);
+    }
+
+    // closest triangle along the ray, only the winning triangle fills in the record
+    bool intersect(const ray &r, interval ray_t, place_hit &rec) const override
+    {
+        uint32_t closest = 0;
+        double closest_t = 0, closest_b1 = 0, closest_b2 = 0;
+
+        auto intersect_triangle = [&](uint32_t triangle, interval &range)
+        {
+            double t, b1, b2;
+
+            if (!hit_triangle(triangle, r, range, t, b1, b2))
+            {
+                return false;
+            }
+
+            range.max = t;
+            closest = triangle;
+            closest_t = t;
+            closest_b1 = b1;
+            closest_b2 = b2;
+
+            return true;
+        };
+
+        if (!bvh.traverse(r, ray_t, intersect_triangle))
+        {
+            return false;
+        }
+
+        // barycentrics wait in u and v for set_hit
+        rec.t = closest_t;
+        rec.u = closest_b1;
+        rec.v = closest_b2;
+        rec.primitive = closest;
+        rec.object = this;
+
+        return true;
+    }
+
+    // fill in the record for the closest triangle
+    void set_hit(const ray &r, place_hit &rec) const override
+    {
+        size_t base = 3 * size_t(rec.primitive);
+        const point3 &p0 = mesh.vertices[mesh.indices[base]];
+        const point3 &p1 = mesh.vertices[mesh.indices[base + 1]];
+        const point3 &p2 = mesh.vertices[mesh.indices[base + 2]];
+        double b1 = rec.u, b2 = rec.v;
+        double b0 = 1 - b1 - b2;
+
+        rec.p = r.at(rec.t);
+        rec.mat = mat.get();
+
+        // same winding and uv convention as the three point triangle
+        vec3 outward_normal = unit_vector(cross(p2 - p0, p1 - p0));
+
+        if (!mesh.normal_indices.empty())
+        {
+            vec3 shading = b0 * mesh.normals[mesh.normal_indices[base]] + b1 * mesh.normals[mesh.normal_indices[base + 1]] +
+                           b2 * mesh.normals[mesh.normal_indices[base + 2]];
+
+            if (shading.length_squared() > 0)
+            {
+                outward_normal = unit_vector(shading);
+            }
+        }
+
+        rec.set_face_normal(r, outward_normal);
+
+        if (!mesh.uv_indices.empty())
+        {
+            const double *uv0 = &mesh.uvs[2 * size_t(mesh.uv_indices[base])];
+            const double *uv1 = &mesh.uvs[2 * size_t(mesh.uv_indices[base + 1])];
+            const double *uv2 = &mesh.uvs[2 * size_t(mesh.uv_indices[base + 2])];
+
+            rec.u = b0 * uv0[0] + b1 * uv1[0] + b2 * uv2[0];
+            rec.v = b0 * uv0[1] + b1 * uv1[1] + b2 * uv2[1];
+        }
+        else
+        {
+            rec.u = b2;
+            rec.v = b1;
+        }
+    }
+
+    // get the bounding box
+    AA_bounding_box bounding_box() const override
+    {
+        return aa_bound_box;
+    }
+
+    // hash of the vertices, the triangles, and the material
+    uint64_t fingerprint() const override
+    {
+        uint64_t hash = hash_combine(hash_combine(mesh.vertices.size(), mesh.indices.size()), material_fingerprint(mat.get()));
+
+        for (const point3 &vertex : mesh.vertices)
+        {
+            hash = hash_double(hash_double(hash_double(hash, vertex.x()), vertex.y()), vertex.z());
+        }
+
+        for (uint32_t index : mesh.indices)
+        {
+            hash = hash_combine(hash, index);
+        }
+
+        return hash;
+    }
+
+    // number of triangles
+    size_t triangle_count() const
+    {
+        return mesh.indices.size() / 3;
+    }
+
+    // bytes held by the buffers and the hierarchy
+    size_t memory_bytes() const
+    {
+        return sizeof(*this) + mesh.vertices.capacity() * sizeof(point3) + mesh.indices.capacity() * sizeof(uint32_t) +
+               mesh.normals.capacity() * sizeof(vec3) + mesh.normal_indices.capacity() * sizeof(uint32_t) +
+               mesh.uvs.capacity() * sizeof(double) + mesh.uv_indices.capacity() * sizeof(uint32_t) +
+               bvh.nodes.capacity() * sizeof(linear_bvh_node) + bvh.primitive_indices.capacity() * sizeof(uint32_t);
+    }
+
+    // numbers from the hierarchy build
+    const bvh_build_stats &bvh_stats() const
+    {
+        return bvh.stats;
+    }
+
+private:
+    triangle_mesh_data mesh;
+    shared_ptr<material> mat;
+    linear_bvh bvh;
+    AA_bounding_box aa_bound_box;
+
+    // every index must point into its buffer and the optional index lists must match the triangles
+    bool valid() const
+    {
+        if (mesh.indices.size() % 3 != 0)
+        {
+            return false;
+        }
+
+        for (uint32_t index : mesh.indices)
+        {
+            if (index >= mesh.vertices.size())
+            {
+                return false;
+            }
+        }
+
+        if (!mesh.normal_indices.empty())
+        {
+            if (mesh.normal_indices.size() != mesh.indices.size())
+            {
+                return false;
+            }
+
+            for (uint32_t index : mesh.normal_indices)
+            {
+                if (index >= mesh.normals.size())
+                {
+                    return false;
+                }
+            }
+        }
+
+        if (!mesh.uv_indices.empty())
+        {
+            if (mesh.uv_indices.size() != mesh.indices.size())
+            {
+                return false;
+            }
+
+            for (uint32_t index : mesh.uv_indices)
+            {
+                if (size_t(index) * 2 + 1 >= mesh.uvs.size())
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // build the hierarchy, then store the triangles in leaf order so a leaf reads one run of indices
+    void build(const bvh_build_settings &settings, const bvh_cache &cache)
+    {
+        size_t count = triangle_count();
+        std::vector<bvh_primitive> refs(count);
+
+        auto fill = [&](int, size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                const point3 &a = mesh.vertices[mesh.indices[3 * i]];
+                const point3 &b = mesh.vertices[mesh.indices[3 * i + 1]];
+                const point3 &c = mesh.vertices[mesh.indices[3 * i + 2]];
+
+                refs[i].box = AA_bounding_box(AA_bounding_box(a, b), AA_bounding_box(c, c));
+                refs[i].centroid = refs[i].box.centroid();
+                refs[i].index = i;
+            }
+        };
+
+        int chunks = static_cast<int>(std::min<size_t>(bvh_build_threads(settings), count / bvh_parallel_min_objects(settings) + 1));
+        bvh_parallel_chunks(0, count, chunks, fill);
+
+        cache.build(bvh, refs, settings);
+
+        reorder(mesh.indices);
+        reorder(mesh.normal_indices);
+        reorder(mesh.uv_indices);
+
+        for (size_t i = 0; i < bvh.primitive_indices.size(); i++)
+        {
+            bvh.primitive_indices[i] = static_cast<uint32_t>(i);
+        }
+
+        aa_bound_box = count > 0 ? bvh.bounding_box() : AA_bounding_box();
+    }
+
+    // move the three entries of every triangle to its slot in the hierarchy leaves
+    void reorder(std::vector<uint32_t> &triangle_indices) const
+    {
+        if (triangle_indices.empty())
+        {
+            return;
+        }
+
+        std::vector<uint32_t> ordered(triangle_indices.size());
+
+        for (size_t i = 0; i < bvh.primitive_indices.size(); i++)
+        {
+            size_t from = bvh.primitive_indices[i];
+
+            ordered[3 * i] = triangle_indices[3 * from];
+            ordered[3 * i + 1] = triangle_indices[3 * from + 1];
+            ordered[3 * i + 2] = triangle_indices[3 * from + 2];
+        }
+
+        triangle_indices.swap(ordered);
+    }
+
+    // moller-trumbore test, b1 and b2 are the weights of the second and third vertex
+    bool hit_triangle(uint32_t triangle, const ray &r, const interval &ray_t, double &t, double &b1, double &b2) const
+    {
+        const point3 &p0 = mesh.vertices[mesh.indices[3 * triangle]];
+        const point3 &p1 = mesh.vertices[mesh.indices[3 * triangle + 1]];
+        const point3 &p2 = mesh.vertices[mesh.indices[3 * triangle + 2]];
+
+        vec3 edge1 = p1 - p0;
+        vec3 edge2 = p2 - p0;
+        vec3 p = cross(r.direction(), edge2);
+        double det = dot(edge1, p);
+
+        // return if the ray runs along the triangle
+        if (std::fabs(det) < 1e-12)
+        {
+            return false;
+        }
+
+        double inv_det = 1 / det;
+        vec3 s = r.origin() - p0;
+        b1 = dot(s, p) * inv_det;
+
+        if (b1 <= 0 || b1 >= 1)
+        {
+            return false;
+        }
+
+        vec3 q = cross(s, edge1);
+        b2 = dot(r.direction(), q) * inv_det;
+
+        if (b2 <= 0 || b1 + b2 >= 1)
+        {
+            return false;
+        }
+
+        t = dot(edge2, q) * inv_det;
+
+        return ray_t.contains(t);
+    }
+};
+
+#endif
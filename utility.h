@@ -5,16 +5,22 @@
 
 // C utilities
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <fstream>
 #include <iostream>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <random>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 // C++ Std Usings
@@ -25,6 +31,9 @@ using std::shared_ptr;
 const double infinity = std::numeric_limits<double>::infinity();
 const double pi = 3.1415926535897932385;
 
+// random number generator
+#include "rng.h"
+
 // Utility Functions
 void clearLine()
 {
@@ -38,10 +47,7 @@ inline double degrees_to_radians(double degrees)
 
 inline double random_double()
 {
-    static std::uniform_real_distribution<double> distribution(0.0, 1.0);
-    static std::mt19937 generator;
-
-    return distribution(generator);
+    return thread_rng().next_double();
 }
 
 inline double random_double(double min, double max)
@@ -54,6 +60,42 @@ inline int random_int(int min, int max)
     return int(random_double(min, max + 1));
 }
 
+// fold a value into a running hash, used for scene and camera fingerprints
+inline uint64_t hash_combine(uint64_t hash, uint64_t value)
+{
+    return hash_mix(hash ^ (value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2)));
+}
+
+inline uint64_t hash_double(uint64_t hash, double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    return hash_combine(hash, bits);
+}
+
+// hash of a block of bytes, catches truncated or damaged files
+inline uint64_t hash_bytes(const unsigned char *data, size_t size)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    size_t i = 0;
+
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * 0x100000001b3ULL;
+        hash ^= hash >> 29;
+    }
+
+    for (; i < size; i++)
+    {
+        hash = (hash ^ uint8_t(data[i])) * 0x100000001b3ULL;
+    }
+
+    return hash_mix(hash);
+}
+
 // interval utilites
 // interval
 class interval {
@@ -71,12 +71,18 @@ public:
 
     // set the point of intersect variables
     rec.t = rec1.t + hit_distance / ray_length;
+    rec.object = this;
+
+    return true;
+  }
+
+  // function to fill in the scatter point of the closest hit
+  void set_hit(const ray &r, place_hit &rec) const override
+  {
     rec.p = r.at(rec.t);
     rec.normal = vec3(1, 0, 0);
     rec.front_face = true;
-    rec.mat = volume_material;
-
-    return true;
+    rec.mat = volume_material.get();
   }
 
   // function to return the axis aligned bounding box
@@ -85,6 +91,12 @@ public:
     return fitted_object->bounding_box();
   }
 
+  // hash of the shape, the density, and the material
+  uint64_t fingerprint() const override
+  {
+    return hash_combine(hash_double(fitted_object->fingerprint(), density), material_fingerprint(volume_material.get()));
+  }
+
 private:
   // density of the volume object
   double density;
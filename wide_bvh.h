@@ -0,0 +1,481 @@
+#ifndef WIDE_BVH_H
+#define WIDE_BVH_H
+
+// header file for the 4 and 8 wide bounding volume hierarchy, collapsed from the binary linear_bvh and tested
+// with sse / avx2 slab tests on every child box at once
+
+// include
+#include "utility.h"
+#include "linear_bvh.h"
+
+// x86 intrinsics, everything else uses the scalar kernel
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define WIDE_BVH_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// let gcc and clang compile the avx2 kernel without building the whole program for avx2
+#if defined(__GNUC__) || defined(__clang__)
+#define WIDE_BVH_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define WIDE_BVH_TARGET_AVX2
+#endif
+
+// instruction set used for the child box tests
+enum class simd_level
+{
+    scalar,
+    sse,
+    avx2
+};
+
+// ask the cpu for the best instruction set it supports (cpuid and xgetbv, use detect_simd_level)
+inline simd_level query_simd_level()
+{
+#if defined(WIDE_BVH_X86)
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+
+    if (info[0] >= 7)
+    {
+        __cpuid(info, 1);
+        bool os_saves_ymm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv(0) & 6) == 6);
+
+        __cpuidex(info, 7, 0);
+
+        if (os_saves_ymm && (info[1] & (1 << 5)))
+        {
+            return simd_level::avx2;
+        }
+    }
+
+    return simd_level::sse;
+#else
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return simd_level::avx2;
+    }
+
+    return __builtin_cpu_supports("sse2") ? simd_level::sse : simd_level::scalar;
+#endif
+#else
+    return simd_level::scalar;
+#endif
+}
+
+// best instruction set this cpu supports, asked once and remembered
+inline simd_level detect_simd_level()
+{
+    static const simd_level level = query_simd_level();
+
+    return level;
+}
+
+// node with Width children, child boxes stored as one float array per bound (structure of arrays)
+template <int Width>
+struct wide_bvh_node
+{
+    // min x, y, z then max x, y, z of every child, empty slots hold an inverted box
+    alignas(32) float bounds[6][Width];
+
+    // child node index, leaf_flag | leaf index, or empty_slot
+    uint32_t child[Width];
+};
+
+// ray prepared for the float slab tests
+struct wide_bvh_ray
+{
+    // origin moved back along the ray for the near planes and forward for the far planes, by more than the float
+    // rounding of the origin, so a box the double ray grazes is never culled
+    float near_origin[3];
+    float far_origin[3];
+    float inv_dir[3];
+
+    // bounds row holding the near and far plane of each axis for this ray direction
+    int near_row[3];
+    int far_row[3];
+};
+
+// child box test kernels, each returns a bit mask of the children hit and their entry distance
+namespace wide_bvh_kernels
+{
+    // pushes the far distances up by 2 * gamma(3) so float rounding never culls a box the ray touches
+    const float far_scale = 1.0000004f;
+
+    // one child at a time
+    template <int Width>
+    int hit_scalar(const wide_bvh_node<Width> &node, const wide_bvh_ray &r, float t_min, float t_max, float *t_entry)
+    {
+        int mask = 0;
+
+        for (int lane = 0; lane < Width; lane++)
+        {
+            float t_near = t_min, t_far = t_max;
+
+            for (int axis = 0; axis < 3; axis++)
+            {
+                float t0 = (node.bounds[r.near_row[axis]][lane] - r.near_origin[axis]) * r.inv_dir[axis];
+                float t1 = (node.bounds[r.far_row[axis]][lane] - r.far_origin[axis]) * r.inv_dir[axis] * far_scale;
+
+                // written so a nan distance (zero direction on a plane) keeps the running value
+                t_near = t0 > t_near ? t0 : t_near;
+                t_far = t1 < t_far ? t1 : t_far;
+            }
+
+            t_entry[lane] = t_near;
+
+            if (t_near <= t_far)
+            {
+                mask |= 1 << lane;
+            }
+        }
+
+        return mask;
+    }
+
+#if defined(WIDE_BVH_X86)
+    // four children per sse instruction
+    template <int Width>
+    int hit_sse(const wide_bvh_node<Width> &node, const wide_bvh_ray &r, float t_min, float t_max, float *t_entry)
+    {
+        int mask = 0;
+
+        for (int lane = 0; lane < Width; lane += 4)
+        {
+            __m128 t_near = _mm_set1_ps(t_min);
+            __m128 t_far = _mm_set1_ps(t_max);
+
+            for (int axis = 0; axis < 3; axis++)
+            {
+                __m128 near_origin = _mm_set1_ps(r.near_origin[axis]);
+                __m128 far_origin = _mm_set1_ps(r.far_origin[axis]);
+                __m128 inv_dir = _mm_set1_ps(r.inv_dir[axis]);
+
+                __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&node.bounds[r.near_row[axis]][lane]), near_origin), inv_dir);
+                __m128 t1 = _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(_mm_load_ps(&node.bounds[r.far_row[axis]][lane]), far_origin), inv_dir), _mm_set1_ps(far_scale));
+
+                // maxps / minps return the second operand when the first is nan
+                t_near = _mm_max_ps(t0, t_near);
+                t_far = _mm_min_ps(t1, t_far);
+            }
+
+            _mm_storeu_ps(t_entry + lane, t_near);
+            mask |= _mm_movemask_ps(_mm_cmple_ps(t_near, t_far)) << lane;
+        }
+
+        return mask;
+    }
+
+    // eight children per avx2 instruction
+    template <int Width>
+    WIDE_BVH_TARGET_AVX2 int hit_avx2(const wide_bvh_node<Width> &node, const wide_bvh_ray &r, float t_min, float t_max, float *t_entry)
+    {
+        int mask = 0;
+
+        for (int lane = 0; lane < Width; lane += 8)
+        {
+            __m256 t_near = _mm256_set1_ps(t_min);
+            __m256 t_far = _mm256_set1_ps(t_max);
+
+            for (int axis = 0; axis < 3; axis++)
+            {
+                __m256 near_origin = _mm256_set1_ps(r.near_origin[axis]);
+                __m256 far_origin = _mm256_set1_ps(r.far_origin[axis]);
+                __m256 inv_dir = _mm256_set1_ps(r.inv_dir[axis]);
+
+                __m256 t0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(&node.bounds[r.near_row[axis]][lane]), near_origin), inv_dir);
+                __m256 t1 = _mm256_mul_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(&node.bounds[r.far_row[axis]][lane]), far_origin), inv_dir), _mm256_set1_ps(far_scale));
+
+                t_near = _mm256_max_ps(t0, t_near);
+                t_far = _mm256_min_ps(t1, t_far);
+            }
+
+            _mm256_storeu_ps(t_entry + lane, t_near);
+            mask |= _mm256_movemask_ps(_mm256_cmp_ps(t_near, t_far, _CMP_LE_OQ)) << lane;
+        }
+
+        return mask;
+    }
+#endif
+}
+
+// wide_bvh
+template <int Width>
+class wide_bvh
+{
+    static_assert(Width == 4 || Width == 8, "wide_bvh supports 4 and 8 children per node");
+
+public:
+    // leaf: a range of primitive_indices
+    struct leaf
+    {
+        uint32_t first, count;
+    };
+
+    static const uint32_t leaf_flag = 0x80000000u;
+    static const uint32_t empty_slot = 0xffffffffu;
+
+    // nodes, nodes[0] is the root
+    std::vector<wide_bvh_node<Width>> nodes;
+    std::vector<leaf> leaves;
+
+    // primitive of each leaf slot, same meaning as in linear_bvh
+    std::vector<uint32_t> primitive_indices;
+
+    // constructor for an empty hierarchy
+    wide_bvh() { use_simd(detect_simd_level()); }
+
+    // constructor to collapse a binary hierarchy, using the best kernel this cpu supports
+    wide_bvh(const linear_bvh &binary, simd_level level = detect_simd_level())
+    {
+        use_simd(level);
+        build(binary);
+    }
+
+    // collapse the binary hierarchy into nodes of up to Width children
+    void build(const linear_bvh &binary)
+    {
+        nodes.clear();
+        leaves.clear();
+        primitive_indices = binary.primitive_indices;
+
+        if (binary.nodes.empty())
+        {
+            return;
+        }
+
+        collapse(binary, 0);
+    }
+
+    // pick the child box kernel, falling back to whatever this build and cpu can run
+    void use_simd(simd_level level)
+    {
+        kernel = &wide_bvh_kernels::hit_scalar<Width>;
+        active_level = simd_level::scalar;
+
+#if defined(WIDE_BVH_X86)
+        simd_level supported = detect_simd_level();
+
+        if (level == simd_level::avx2 && supported == simd_level::avx2 && Width == 8)
+        {
+            kernel = &wide_bvh_kernels::hit_avx2<Width>;
+            active_level = simd_level::avx2;
+        }
+
+        else if (level != simd_level::scalar && supported != simd_level::scalar)
+        {
+            kernel = &wide_bvh_kernels::hit_sse<Width>;
+            active_level = simd_level::sse;
+        }
+#endif
+    }
+
+    // kernel in use
+    simd_level simd() const { return active_level; }
+
+    // walk the hierarchy nearest child first, same contract as linear_bvh::traverse
+    template <typename Intersect>
+    bool traverse(const ray &r, interval ray_t, Intersect &&intersect_primitive) const
+    {
+        if (nodes.empty())
+        {
+            return false;
+        }
+
+        wide_bvh_ray wr;
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            wr.inv_dir[axis] = static_cast<float>(1.0 / r.direction()[axis]);
+
+            bool negative = wr.inv_dir[axis] < 0;
+            wr.near_row[axis] = negative ? 3 + axis : axis;
+            wr.far_row[axis] = negative ? axis : 3 + axis;
+
+            // rounding the origin to float moves it by up to half a float ulp, pad by a few ulps of its magnitude
+            double origin = r.origin()[axis];
+            double pad = std::fabs(origin) * origin_pad;
+
+            wr.near_origin[axis] = static_cast<float>(negative ? origin - pad : origin + pad);
+            wr.far_origin[axis] = static_cast<float>(negative ? origin + pad : origin - pad);
+        }
+
+        // entries remember how far along the ray their box starts so boxes behind a closer hit are skipped
+        struct entry
+        {
+            uint32_t ref;
+            float t;
+        };
+
+        // the clip range in float is rounded outward and its end gets the far plane slack, so a box entered just
+        // before the closest hit is never culled or skipped
+        float t_min = std::nextafter(static_cast<float>(ray_t.min), -std::numeric_limits<float>::infinity());
+
+        auto clip_max = [](const interval &range)
+        {
+            return range.max < std::numeric_limits<float>::max()
+                       ? std::nextafter(static_cast<float>(range.max), std::numeric_limits<float>::infinity()) * wide_bvh_kernels::far_scale
+                       : std::numeric_limits<float>::infinity();
+        };
+
+        entry stack[(Width - 1) * linear_bvh::max_depth + 1];
+        int stack_size = 0;
+        stack[stack_size++] = {0, -std::numeric_limits<float>::infinity()};
+
+        bool is_hit = false;
+        alignas(32) float t_entry[Width];
+
+        while (stack_size > 0)
+        {
+            entry current = stack[--stack_size];
+
+            if (current.t > clip_max(ray_t))
+            {
+                continue;
+            }
+
+            if (current.ref & leaf_flag)
+            {
+                const leaf &l = leaves[current.ref & ~leaf_flag];
+
+                for (uint32_t i = l.first; i < l.first + l.count; i++)
+                {
+                    if (intersect_primitive(primitive_indices[i], ray_t))
+                    {
+                        is_hit = true;
+                    }
+                }
+
+                continue;
+            }
+
+            const wide_bvh_node<Width> &node = nodes[current.ref];
+            int mask = kernel(node, wr, t_min, clip_max(ray_t), t_entry);
+
+            // push the children hit, farthest first so the nearest is popped next
+            int first = stack_size;
+
+            for (int lane = 0; lane < Width; lane++)
+            {
+                if (mask & (1 << lane))
+                {
+                    entry e = {node.child[lane], t_entry[lane]};
+                    int slot = stack_size++;
+
+                    while (slot > first && stack[slot - 1].t < e.t)
+                    {
+                        stack[slot] = stack[slot - 1];
+                        slot--;
+                    }
+
+                    stack[slot] = e;
+                }
+            }
+        }
+
+        return is_hit;
+    }
+
+private:
+    // origin padding relative to its magnitude, at least 4 float ulps (2^-21) so the padded origin still covers the double
+    // one after being rounded to float itself
+    static constexpr double origin_pad = 1.0 / (1 << 21);
+
+    int (*kernel)(const wide_bvh_node<Width> &, const wide_bvh_ray &, float, float, float *);
+    simd_level active_level;
+
+    // make the wide node for the binary node and return its index
+    uint32_t collapse(const linear_bvh &binary, uint32_t binary_index)
+    {
+        uint32_t index = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+
+        // open the largest interior child until the node is full
+        std::vector<uint32_t> children;
+        const linear_bvh_node &root = binary.nodes[binary_index];
+
+        if (root.count > 0)
+        {
+            children.push_back(binary_index);
+        }
+
+        else
+        {
+            children.push_back(binary_index + 1);
+            children.push_back(root.offset);
+        }
+
+        while (children.size() < size_t(Width))
+        {
+            int largest = -1;
+            double largest_area = -1;
+
+            for (size_t i = 0; i < children.size(); i++)
+            {
+                const linear_bvh_node &child = binary.nodes[children[i]];
+                double area = linear_bvh::node_box(child).surface_area();
+
+                if (child.count == 0 && area > largest_area)
+                {
+                    largest = int(i);
+                    largest_area = area;
+                }
+            }
+
+            if (largest < 0)
+            {
+                break;
+            }
+
+            uint32_t opened = children[largest];
+            children[largest] = opened + 1;
+            children.push_back(binary.nodes[opened].offset);
+        }
+
+        // fill the slots, recursing into interior children (nodes may grow, so index instead of holding a reference)
+        for (int lane = 0; lane < Width; lane++)
+        {
+            if (lane >= int(children.size()))
+            {
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    nodes[index].bounds[axis][lane] = std::numeric_limits<float>::infinity();
+                    nodes[index].bounds[3 + axis][lane] = -std::numeric_limits<float>::infinity();
+                }
+
+                nodes[index].child[lane] = empty_slot;
+                continue;
+            }
+
+            const linear_bvh_node &child = binary.nodes[children[lane]];
+
+            for (int axis = 0; axis < 3; axis++)
+            {
+                nodes[index].bounds[axis][lane] = child.bounds_min[axis];
+                nodes[index].bounds[3 + axis][lane] = child.bounds_max[axis];
+            }
+
+            if (child.count > 0)
+            {
+                leaves.push_back({child.offset, child.count});
+                nodes[index].child[lane] = leaf_flag | static_cast<uint32_t>(leaves.size() - 1);
+            }
+
+            else
+            {
+                uint32_t child_index = collapse(binary, children[lane]);
+                nodes[index].child[lane] = child_index;
+            }
+        }
+
+        return index;
+    }
+};
+
+#endif
@@ -10,14 +10,54 @@
 #include "quad.h"
 #include "volume.h"
 #include "material.h"
+#include "ssas.h"
+#include "linear_bvh.h"
+#include "wide_bvh.h"
+#include "bvh_cache.h"
+#include "scene_arena.h"
+
+#include <array>
+#include <unordered_map>
+
+// how the world finds the closest hit
+enum class traversal_mode
+{
+    // test every object in order (kept for benchmarking)
+    flat,
+    // walk the spatial_sub_acc_struct built over the objects
+    bvh,
+    // walk the flattened linear_bvh built over the objects
+    linear_bvh,
+    // walk the linear_bvh collapsed to 4 or 8 children per node, testing the child boxes with simd
+    wide_bvh4,
+    wide_bvh8
+};
 
 // world class
 class world : public hittable
 {
 public:
     // the "world" in a vector of hittable items
+    // (objects pushed here directly must be followed by a call to invalidate())
     std::vector<shared_ptr<hittable>> objects;
 
+    // traversal used by intersect
+    traversal_mode traversal = traversal_mode::wide_bvh8;
+
+    // how the acceleration structure is built (changes take effect after invalidate())
+    bvh_build_settings bvh_settings;
+
+    // instruction set for the wide hierarchy box tests, defaults to the best this cpu has
+    simd_level bvh_simd = detect_simd_level();
+
+    // built hierarchies for big scenes are kept on disk and reused when the same scene is loaded again
+    bvh_cache bvh_disk_cache;
+
+    // emissive spheres, quads, and triangles added through the add functions, sampled directly by the camera
+    // (emitters passed to add(), and emitters inside instances and meshes, are not in the list and are only found by
+    // the scattered rays)
+    std::vector<shared_ptr<hittable>> lights;
+
     // constructors
     world() {}
     world(shared_ptr<hittable> object) { add(object); }
@@ -26,12 +66,12 @@ public:
         // for if a default floor in the final render is wanted
         if (floor)
         {
-            add_sphere(point3(0, -100.5, -1), 100, "diffuse", texture_vector(50, 50, 50, 0, 0));
+            add_sphere(point3(0, -100.5, -1), 100, material_type::diffuse, texture_vector(50, 50, 50, 0, 0));
         }
     }
 
     // adds a sphere to the world with a given center, radius, material type, and texture vector
-    void add_sphere(point3 center, double radius, std::string mat, texture_vector texture_vector)
+    void add_sphere(point3 center, double radius, material_type mat, texture_vector texture_vector)
     {
         point3 &center_ref = center;
 
@@ -40,15 +80,17 @@ public:
         min_height = center.y() - radius;
 
         // create sphere
-        shared_ptr<hittable> sphere_object = make_shared<sphere>(center_ref, radius, get_material(mat, texture_vector));
+        shared_ptr<hittable> sphere_object = make_object<sphere>(center_ref, radius, get_material(mat, texture_vector));
 
         // add to world vector and the bounding box
         objects.push_back(sphere_object);
+        add_light(sphere_object, mat);
+        invalidate();
         aa_bound_box = AA_bounding_box(aa_bound_box, sphere_object->bounding_box());
     }
 
     // adds a moving sphere to the world with a given center and max movement center, radius, material type, and texture vector
-    void add_moving_sphere(point3 center1, point3 center2, double radius, std::string mat, texture_vector tv)
+    void add_moving_sphere(point3 center1, point3 center2, double radius, material_type mat, texture_vector tv)
     {
         point3 &center1_ref = center1;
         point3 &center2_ref = center2;
@@ -58,15 +100,17 @@ public:
         min_height = std::min((center1.y() - radius), (center2.y() - radius));
 
         // create moving sphere
-        shared_ptr<hittable> sphere_object = make_shared<sphere>(center1, center2, radius, get_material(mat, tv));
+        shared_ptr<hittable> sphere_object = make_object<sphere>(center1, center2, radius, get_material(mat, tv));
 
         // add to world vector
         objects.push_back(sphere_object);
+        add_light(sphere_object, mat);
+        invalidate();
         aa_bound_box = AA_bounding_box(aa_bound_box, sphere_object->bounding_box());
     }
 
     // adds a triangle to the world with a given point Q, vectors u and v, material type, and texture vector
-    void add_triangle(point3 Q, vec3 u, vec3 v, std::string mat, texture_vector texture_vector)
+    void add_triangle(point3 Q, vec3 u, vec3 v, material_type mat, texture_vector texture_vector)
     {
         point3 &point = Q;
         vec3 &vector_u = u;
@@ -77,15 +121,17 @@ public:
         min_height = get_min_y(Q.y(), Q.y() + u.y(), Q.y() + v.y());
 
         // create triangle
-        shared_ptr<hittable> triangle_object = make_shared<triangle>(point, vector_u, vector_v, get_material(mat, texture_vector));
+        shared_ptr<hittable> triangle_object = make_object<triangle>(point, vector_u, vector_v, get_material(mat, texture_vector));
 
         // add to the world vector
         objects.push_back(triangle_object);
+        add_light(triangle_object, mat);
+        invalidate();
         aa_bound_box = AA_bounding_box(aa_bound_box, triangle_object->bounding_box());
     }
 
     // adds a triangle to the world with a given point Q, X, and Y, material type, and texture vector
-    void add_triangle(int differ, point3 Q, point3 X, point3 Y, std::string mat, texture_vector texture_vector)
+    void add_triangle(int differ, point3 Q, point3 X, point3 Y, material_type mat, texture_vector texture_vector)
     {
         point3 &point_q = Q;
         vec3 &point_x = X;
@@ -96,15 +142,17 @@ public:
         min_height = get_min_y(Q.y(), X.y(), Y.y());
 
         // create triangle
-        shared_ptr<hittable> triangle_object = make_shared<triangle>(1, point_q, point_x, point_y, get_material(mat, texture_vector));
+        shared_ptr<hittable> triangle_object = make_object<triangle>(1, point_q, point_x, point_y, get_material(mat, texture_vector));
 
         // add to world
         objects.push_back(triangle_object);
+        add_light(triangle_object, mat);
+        invalidate();
         aa_bound_box = AA_bounding_box(aa_bound_box, triangle_object->bounding_box());
     }
 
     // adds a quad to the world with a given point Q, vectors u and v, material type, and texture vector
-    void add_quad(point3 Q, vec3 u, vec3 v, std::string mat, texture_vector texture_vector)
+    void add_quad(point3 Q, vec3 u, vec3 v, material_type mat, texture_vector texture_vector)
     {
         point3 &point = Q;
         vec3 &vector_u = u;
@@ -115,15 +163,17 @@ public:
         min_height = get_min_y(Q.y(), Q.y() + u.y(), Q.y() + v.y());
 
         // create quad object
-        shared_ptr<hittable> quad_object = make_shared<quad>(point, vector_u, vector_v, get_material(mat, texture_vector));
+        shared_ptr<hittable> quad_object = make_object<quad>(point, vector_u, vector_v, get_material(mat, texture_vector));
 
         // add to world
         objects.push_back(quad_object);
+        add_light(quad_object, mat);
+        invalidate();
         aa_bound_box = AA_bounding_box(aa_bound_box, quad_object->bounding_box());
     }
 
     // adds a quad to the world with a given point Q, X, and Y, material type, and texture vector
-    void add_quad(int differ, point3 Q, point3 X, point3 Y, std::string mat, texture_vector texture_vector)
+    void add_quad(int differ, point3 Q, point3 X, point3 Y, material_type mat, texture_vector texture_vector)
     {
         point3 &point_q = Q;
         vec3 &point_x = X;
@@ -134,15 +184,17 @@ public:
         min_height = get_min_y(Q.y(), X.y(), Y.y());
 
         // create quad
-        shared_ptr<hittable> quad_object = make_shared<quad>(point_q, point_x, point_y, get_material(mat, texture_vector));
+        shared_ptr<hittable> quad_object = make_object<quad>(point_q, point_x, point_y, get_material(mat, texture_vector));
 
         // add to world
         objects.push_back(quad_object);
+        add_light(quad_object, mat);
+        invalidate();
         aa_bound_box = AA_bounding_box(aa_bound_box, quad_object->bounding_box());
     }
 
     // adds a volume object to the world with a given object, density, material type, and texture vector
-    void add_volume(shared_ptr<hittable> fitted_object, double density, std::string mat, texture_vector tv)
+    void add_volume(shared_ptr<hittable> fitted_object, double density, material_type, texture_vector tv)
     {
         // get volume colors
         double red = tv.red() / 100;
@@ -154,6 +206,7 @@ public:
 
         // add to the world
         objects.push_back(volume_object);
+        invalidate();
         aa_bound_box = AA_bounding_box(aa_bound_box, volume_object->bounding_box());
     }
 
@@ -162,34 +215,165 @@ public:
     {
         // add object to world vector
         objects.push_back(object);
+        invalidate();
         aa_bound_box = AA_bounding_box(aa_bound_box, object->bounding_box());
     }
 
     // function for detecting hits in the world vector
     bool intersect(const ray &r, interval ray_t, place_hit &rec) const override
     {
-        place_hit temp;
+        // walk the acceleration structure, built on the first ray after the objects changed
+        if (objects.size() > 1)
+        {
+            switch (traversal)
+            {
+            case traversal_mode::bvh:
+                return acceleration_structure().intersect(r, ray_t, rec);
+            case traversal_mode::linear_bvh:
+                return traverse_objects(linear_structure(), r, ray_t, rec);
+            case traversal_mode::wide_bvh4:
+                return traverse_objects(wide_structure<4>(), r, ray_t, rec);
+            case traversal_mode::wide_bvh8:
+                return traverse_objects(wide_structure<8>(), r, ray_t, rec);
+            default:
+                break;
+            }
+        }
+
         bool is_hit = false;
         auto closest = ray_t.max;
 
         // loop of the objects that are in the world vector and determine it intersect
+        // (objects only write the record when they are hit closer than closest, so it needs no temporary copy)
         for (const auto &object : objects)
         {
-            if (object->intersect(r, interval(ray_t.min, closest), temp))
+            if (object->intersect(r, interval(ray_t.min, closest), rec))
             {
                 is_hit = true;
-                closest = temp.t;
-                rec = temp;
+                closest = rec.t;
             }
         }
 
         return is_hit;
     }
 
-    // function to clear the world
+    // function to clear the world, its arena goes once nothing points into it anymore
     void clear()
     {
         objects.clear();
+        lights.clear();
+        invalidate();
+        material_registry.clear();
+        texture_registry.clear();
+        perlin_table.reset();
+        arena = make_shared<scene_arena>();
+    }
+
+    // construct a primitive in the scene's arena, the pointer keeps the arena alive and is added like any other object
+    // (primitives built this way must not hold such pointers to other objects of the same arena, or it is never freed)
+    template <typename T, typename... Args>
+    shared_ptr<T> make_object(Args &&...args)
+    {
+        return shared_ptr<T>(arena, arena->create<T>(arena_category::primitives, std::forward<Args>(args)...));
+    }
+
+    // memory the scene's primitives, materials, and textures take up in its arena
+    const scene_arena &memory() const
+    {
+        return *arena;
+    }
+
+    // drop the acceleration structure so the next ray rebuilds it from the objects
+    void invalidate()
+    {
+        std::lock_guard<std::mutex> lock(accel.build_mutex);
+        accel.reset();
+    }
+
+    // get the acceleration structure over the objects, building it if the objects changed
+    const spatial_sub_acc_struct &acceleration_structure() const
+    {
+        // render threads share the world, only the first one to get here builds
+        if (!accel.ready.load(std::memory_order_acquire))
+        {
+            std::lock_guard<std::mutex> lock(accel.build_mutex);
+
+            if (!accel.ready.load(std::memory_order_relaxed))
+            {
+                accel.root = make_shared<spatial_sub_acc_struct>(objects, bvh_settings);
+                accel.ready.store(true, std::memory_order_release);
+            }
+        }
+
+        return *accel.root;
+    }
+
+    // get the flattened hierarchy over the objects, building it if the objects changed
+    const linear_bvh &linear_structure() const
+    {
+        if (!accel.linear_ready.load(std::memory_order_acquire))
+        {
+            std::lock_guard<std::mutex> lock(accel.build_mutex);
+
+            if (!accel.linear_ready.load(std::memory_order_relaxed))
+            {
+                std::vector<bvh_primitive> refs = make_bvh_primitives(objects, bvh_settings);
+                bool from_cache = bvh_disk_cache.build(accel.linear, refs, bvh_settings);
+
+                // objects laid out in leaf order so every leaf reads one contiguous run of pointers
+                accel.ordered_objects.resize(objects.size());
+
+                for (size_t i = 0; i < objects.size(); i++)
+                {
+                    accel.ordered_objects[i] = objects[accel.linear.primitive_indices[i]].get();
+                }
+
+                for (size_t i = 0; i < objects.size(); i++)
+                {
+                    accel.linear.primitive_indices[i] = static_cast<uint32_t>(i);
+                }
+
+                const bvh_build_stats &stats = accel.linear.stats;
+                debugger::getInstance().logToFile(std::string(from_cache ? "bvh loaded" : "bvh built") + " over " + std::to_string(objects.size()) + " objects: " +
+                                                  std::to_string(stats.node_count) + " nodes, " + std::to_string(stats.leaf_count) + " leaves, depth " +
+                                                  std::to_string(stats.depth) + ", sah cost " + std::to_string(stats.sah_cost) + ", " +
+                                                  std::to_string(stats.build_seconds * 1000) + " ms");
+
+                accel.linear_ready.store(true, std::memory_order_release);
+            }
+        }
+
+        return accel.linear;
+    }
+
+    // numbers from the build of the flattened hierarchy (builds it if the objects changed)
+    const bvh_build_stats &bvh_stats() const
+    {
+        return linear_structure().stats;
+    }
+
+    // get the wide hierarchy over the objects, collapsing it from the linear one if the objects changed
+    template <int Width>
+    const wide_bvh<Width> &wide_structure() const
+    {
+        std::atomic<bool> &ready = Width == 4 ? accel.wide4_ready : accel.wide8_ready;
+
+        if (!ready.load(std::memory_order_acquire))
+        {
+            // built first, it takes the build lock itself
+            const linear_bvh &binary = linear_structure();
+
+            std::lock_guard<std::mutex> lock(accel.build_mutex);
+
+            if (!ready.load(std::memory_order_relaxed))
+            {
+                accel.wide<Width>().use_simd(bvh_simd);
+                accel.wide<Width>().build(binary);
+                ready.store(true, std::memory_order_release);
+            }
+        }
+
+        return accel.wide<Width>();
     }
 
     // create the bounding box for acceleration
@@ -198,78 +382,360 @@ public:
         return aa_bound_box;
     }
 
+    // a world is sampled through its lights: the pdf of a direction is the mean of the lights' pdfs, since random picks
+    // one light at random and samples it
+    double pdf_value(const point3 &origin, const vec3 &direction, double time) const override
+    {
+        if (lights.empty())
+        {
+            return 0;
+        }
+
+        double sum = 0;
+
+        for (const auto &light : lights)
+        {
+            sum += light->pdf_value(origin, direction, time);
+        }
+
+        return sum / lights.size();
+    }
+
+    // random direction from origin toward a point of one of the lights at the given time
+    vec3 random(const point3 &origin, double time) const override
+    {
+        if (lights.empty())
+        {
+            return vec3(1, 0, 0);
+        }
+
+        return lights[random_int(0, static_cast<int>(lights.size()) - 1)]->random(origin, time);
+    }
+
+    // hash of every object in order
+    uint64_t fingerprint() const override
+    {
+        uint64_t hash = hash_combine(0, objects.size());
+
+        for (const auto &object : objects)
+        {
+            hash = hash_combine(hash, object->fingerprint());
+        }
+
+        return hash;
+    }
+
 private:
     // heights for texture calculations
     double max_height, min_height;
     // the axis-aligned bounding box
     AA_bounding_box aa_bound_box;
 
+    // lazily built acceleration structures, copies of a world build their own
+    struct accel_cache
+    {
+        shared_ptr<spatial_sub_acc_struct> root;
+        std::atomic<bool> ready{false};
+
+        linear_bvh linear;
+        std::vector<const hittable *> ordered_objects;
+        std::atomic<bool> linear_ready{false};
+
+        wide_bvh<4> wide4;
+        wide_bvh<8> wide8;
+        std::atomic<bool> wide4_ready{false}, wide8_ready{false};
+
+        std::mutex build_mutex;
+
+        accel_cache() {}
+        accel_cache(const accel_cache &) {}
+
+        accel_cache &operator=(const accel_cache &)
+        {
+            reset();
+            return *this;
+        }
+
+        void reset()
+        {
+            root.reset();
+            ready = false;
+
+            linear = linear_bvh();
+            ordered_objects.clear();
+            linear_ready = false;
+
+            wide4 = wide_bvh<4>();
+            wide8 = wide_bvh<8>();
+            wide4_ready = wide8_ready = false;
+        }
+
+        // wide hierarchy of the given width
+        template <int Width>
+        wide_bvh<Width> &wide()
+        {
+            if constexpr (Width == 4)
+            {
+                return wide4;
+            }
+
+            else
+            {
+                return wide8;
+            }
+        }
+    };
+
+    // walk one of the flattened hierarchies, whose primitive indices point into ordered_objects
+    template <typename Hierarchy>
+    bool traverse_objects(const Hierarchy &bvh, const ray &r, interval ray_t, place_hit &rec) const
+    {
+        const hittable *const *ordered = accel.ordered_objects.data();
+
+        auto intersect_object = [&](uint32_t index, interval &t)
+        {
+            if (!ordered[index]->intersect(r, t, rec))
+            {
+                return false;
+            }
+
+            t.max = rec.t;
+            return true;
+        };
+
+        return bvh.traverse(r, ray_t, intersect_object);
+    }
+
+    mutable accel_cache accel;
+
+    // primitives, materials, and textures made by the add functions, copies of a world share it
+    shared_ptr<scene_arena> arena = make_shared<scene_arena>();
+
+    // material or texture in the scene's arena, pointed at without ownership by the primitives that use it
+    template <typename T, typename... Args>
+    shared_ptr<T> make_part(arena_category category, Args &&...args)
+    {
+        return arena_pointer(arena->create<T>(category, std::forward<Args>(args)...));
+    }
+
+    // keep objects with an emissive material in the light list
+    void add_light(shared_ptr<hittable> object, material_type mat)
+    {
+        if (mat == material_type::emissive)
+        {
+            lights.push_back(object);
+        }
+    }
+
+    // function to get the material of the given type and texture vector, materials with the same parameters are made
+    // once and shared by every object that uses them
+    shared_ptr<material> get_material(material_type mat, texture_vector texture_vector)
+    {
+        registry_key key = material_key(mat, texture_vector);
+        auto found = material_registry.find(key);
+
+        if (found != material_registry.end())
+        {
+            return found->second;
+        }
+
+        shared_ptr<material> made = make_material(mat, texture_vector);
+        material_registry.emplace(key, made);
+
+        return made;
+    }
+
     // function to sort material with correct material and apply the texture defined in the vector
-    shared_ptr<material> get_material(std::string mat, texture_vector texture_vector)
+    shared_ptr<material> make_material(material_type mat, const texture_vector &texture_vector)
     {
         // divide rgb values
         double red = texture_vector.red() / 100;
         double green = texture_vector.green() / 100;
         double blue = texture_vector.blue() / 100;
 
-        // specular
-        if (mat == "specular")
+        switch (mat)
         {
-            return make_shared<specular>(color(red, green, blue), texture_vector.fuzz());
-        }
+        case material_type::specular:
+            return make_part<specular>(arena_category::materials, color(red, green, blue), texture_vector.fuzz());
 
         // diffuse (uses texture, need to find texture values based on the vector)
-        else if (mat == "diffuse")
-        {
-            int text_val = texture_vector.texture();
-
+        case material_type::diffuse:
             // define which texture is selected
-            switch (text_val)
+            switch (int(texture_vector.texture()))
             {
             case 0:
                 // solid color
-                return make_shared<diffuse>(color(red, green, blue));
+                return make_part<diffuse>(arena_category::materials, get_texture(texture_type::solid, red, green, blue));
             case 1:
                 // sunset
-                return make_shared<diffuse>(make_shared<sunset>(max_height, min_height));
+                return make_part<diffuse>(arena_category::materials, get_texture(texture_type::sunset, max_height, min_height));
             case 2:
                 // rainbow
-                return make_shared<diffuse>(make_shared<rainbow>(max_height, min_height));
+                return make_part<diffuse>(arena_category::materials, get_texture(texture_type::rainbow, max_height, min_height));
             case 3:
                 // hashed
-                return make_shared<diffuse>(make_shared<hashed>(color(red, green, blue)));
+                return make_part<diffuse>(arena_category::materials, get_texture(texture_type::hashed, red, green, blue));
             case 4:
                 // perlin
-                return make_shared<diffuse>(make_shared<perlin_noise>(4, color(red, green, blue)));
+                return make_part<diffuse>(arena_category::materials, get_texture(texture_type::perlin, red, green, blue));
             default:
                 // debug color
-                return make_shared<diffuse>(color(2.55, 1.02, 2.55));
+                return make_part<diffuse>(arena_category::materials, get_texture(texture_type::solid, 2.55, 1.02, 2.55));
+            }
+
+        case material_type::dielectric:
+            return make_part<dielectric>(arena_category::materials, texture_vector.refraction());
+
+        // lights
+        case material_type::emissive:
+            return make_part<emissive>(arena_category::materials, get_texture(texture_type::solid, red, green, blue));
+
+        // volume rendering
+        case material_type::volume:
+            return make_part<volume_mat>(arena_category::materials, get_texture(texture_type::solid, red, green, blue));
+
+        // custom materials are made by the caller, a request for one is a mistake shown with the debug material
+        case material_type::custom:
+            debugger::getInstance().logToFile("The world cannot build a custom material, add the object with a material of your own through add()");
+            return make_part<diffuse>(arena_category::materials, get_texture(texture_type::solid, 2.55, 1.02, 2.55));
+
+        // color for debugged material
+        default:
+            return make_part<diffuse>(arena_category::materials, get_texture(texture_type::solid, 2.55, 1.02, 2.55));
+        }
+    }
+
+    // what makes two materials or textures the same: their type and the parameters they are made from
+    struct registry_key
+    {
+        int type;
+        std::array<double, 4> values;
+
+        bool operator==(const registry_key &other) const
+        {
+            return type == other.type && values == other.values;
+        }
+    };
+
+    // hash of a registry key
+    struct registry_key_hash
+    {
+        size_t operator()(const registry_key &key) const
+        {
+            uint64_t hash = hash_combine(0, uint64_t(key.type));
+
+            for (double value : key.values)
+            {
+                hash = hash_double(hash, value);
             }
+
+            return static_cast<size_t>(hash);
         }
+    };
+
+    // materials and textures already made, pointing into the arena (emptied with it)
+    std::unordered_map<registry_key, shared_ptr<material>, registry_key_hash> material_registry;
+    std::unordered_map<registry_key, shared_ptr<texture>, registry_key_hash> texture_registry;
+
+    // noise table shared by every perlin texture of the scene
+    shared_ptr<perlin> perlin_table;
+
+    // key of a material, holding only the parameters that material type uses so equal materials always match
+    registry_key material_key(material_type mat, const texture_vector &tv) const
+    {
+        registry_key key{int(mat), {0, 0, 0, 0}};
 
-        // dielectric
-        else if (mat == "dielectric")
+        switch (mat)
         {
-            return make_shared<dielectric>(texture_vector.refraction());
+        case material_type::specular:
+            key.values = {tv.red(), tv.green(), tv.blue(), tv.fuzz()};
+            break;
+
+        case material_type::diffuse:
+        {
+            int text_val = tv.texture();
+
+            // sunset and rainbow are stretched over the height of the object
+            if (text_val == 1 || text_val == 2)
+            {
+                key.values = {double(text_val), max_height, min_height, 0};
+            }
+
+            else if (text_val >= 0 && text_val <= 4)
+            {
+                key.values = {double(text_val), tv.red(), tv.green(), tv.blue()};
+            }
+
+            else
+            {
+                key.values = {-1, 0, 0, 0};
+            }
+
+            break;
         }
 
-        // lights
-        else if (mat == "emissive")
+        case material_type::dielectric:
+            key.values = {tv.refraction(), 0, 0, 0};
+            break;
+
+        case material_type::emissive:
+        case material_type::volume:
+            key.values = {tv.red(), tv.green(), tv.blue(), 0};
+            break;
+
+        default:
+            break;
+        }
+
+        // negative zero counts as zero
+        for (double &value : key.values)
         {
-            return make_shared<emissive>(color(red, green, blue));
+            value += 0.0;
         }
 
-        // volume rendering
-        else if (mat == "volume")
+        return key;
+    }
+
+    // function to get the texture of the given type, made once per set of parameters
+    shared_ptr<texture> get_texture(texture_type type, double a, double b, double c = 0)
+    {
+        registry_key key{int(type), {a + 0.0, b + 0.0, c + 0.0, 0}};
+        auto found = texture_registry.find(key);
+
+        if (found != texture_registry.end())
         {
-            return make_shared<volume_mat>(color(red, green, blue));
+            return found->second;
         }
 
-        // color for debugged material
-        else
+        shared_ptr<texture> made;
+
+        switch (type)
         {
-            return make_shared<diffuse>(color(2.55, 1.02, 2.55));
+        case texture_type::sunset:
+            made = make_part<sunset>(arena_category::textures, a, b);
+            break;
+        case texture_type::rainbow:
+            made = make_part<rainbow>(arena_category::textures, a, b);
+            break;
+        case texture_type::hashed:
+            made = make_part<hashed>(arena_category::textures, color(a, b, c));
+            break;
+        case texture_type::perlin:
+            if (!perlin_table)
+            {
+                perlin_table = make_part<perlin>(arena_category::textures);
+            }
+
+            made = make_part<perlin_noise>(arena_category::textures, 4, color(a, b, c), perlin_table);
+            break;
+        default:
+            made = make_part<solid_color>(arena_category::textures, color(a, b, c));
+            break;
         }
+
+        texture_registry.emplace(key, made);
+
+        return made;
     }
 
     // get the max height of the shape for calculations
@@ -299,4 +765,7 @@ private:
     }
 };
 
+// constructor for with given world, built with the world's settings
+inline spatial_sub_acc_struct::spatial_sub_acc_struct(const world &list) : spatial_sub_acc_struct(list.objects, list.bvh_settings) {}
+
 #endif
\ No newline at end of file